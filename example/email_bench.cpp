@@ -0,0 +1,56 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+#include <cm/stopwatch.h>
+#include <cm/smtp.h>
+
+/*
+ * Times the address parser over the lines of the standard input.
+ *
+ *	cm-email-bench 200 < test/data/email.valid.txt
+ *	cm-email-bench 200 < test/data/email.invalid.txt
+ */
+int main(int argc, char **argv) {
+
+	size_t rounds = 100;
+
+	if (argc > 1)
+		rounds = std::strtoul(argv[1], nullptr, 10);
+
+	std::vector<std::string> lines;
+	std::string line;
+
+	while (std::getline(std::cin, line))
+		lines.push_back(line);
+
+	if (lines.empty() || rounds == 0)
+		return 1;
+
+	size_t good = 0;
+	for (const auto &l : lines)
+		if (! cm::smtp::address(l).has_error())
+			++good;
+
+	size_t errors = 0;
+
+	cm::hires_stopwatch::duration elapsed;
+	{
+		cm::hires_stopwatch sw(elapsed);
+
+		for (size_t r = 0; r < rounds; ++r)
+			for (const auto &l : lines)
+				errors += cm::smtp::address(l).has_error();
+	}
+
+	double ns = cm::to_seconds(elapsed) * 1e9 / ( rounds * lines.size() );
+
+	std::cout << " # LINES:" << lines.size() << std::endl;
+	std::cout << "  # GOOD:" << good << std::endl;
+	std::cout << "   # BAD:" << lines.size() - good << std::endl;
+	std::cerr << "ns/address > " << std::setprecision(5) << ns << std::endl;
+
+	return errors == ( lines.size() - good ) * rounds ? 0 : 1;
+}
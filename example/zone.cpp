@@ -0,0 +1,44 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include <cm/stopwatch.h>
+#include <cm/zone.h>
+
+
+int main(int argc, char ** argv) {
+
+	if (argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <zone file> [origin] [threads]" << std::endl;
+		return 1;
+	}
+
+	std::string origin;
+	unsigned threads = 0;
+
+	if (argc > 2)
+		origin = argv[2];
+
+	if (argc > 3)
+		threads = std::stoul(argv[3]);
+
+	std::cout << "-----------------------------------------------------------------" << std::endl;
+
+	cm::hires_stopwatch::duration elapsed;
+	cm::dns::zone::ptr z;
+
+	{
+		cm::hires_stopwatch w(elapsed);
+		z = cm::dns::zone::open(argv[1], origin, threads);
+	}
+
+	for (const auto &e : z->errors())
+		std::cout << argv[1] << ":" << e.line << ": " << e.message << std::endl;
+
+	std::cout << "-----------------------------------------------------------------" << std::endl;
+	std::cout << " # RECORDS:" << z->records() << std::endl;
+	std::cout << "  # ERRORS:" << z->error_count() << std::endl;
+	std::cout << " (" << std::setprecision(10) << std::fixed << cm::to_us(elapsed) << "µs)" << std::endl;
+
+	return z->has_error() ? 1 : 0;
+}
@@ -0,0 +1,421 @@
+#ifndef _CM_SMTP_ADDRESS_LIST_
+#define _CM_SMTP_ADDRESS_LIST_
+
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/smtp.h>
+
+/*
+
+	Address specification - http://tools.ietf.org/html/rfc5322#section-3.4
+
+	address-list    =   (address *("," address)) / obs-addr-list
+	address         =   mailbox / group
+	mailbox         =   name-addr / addr-spec
+	name-addr       =   [display-name] angle-addr
+	angle-addr      =   [CFWS] "<" addr-spec ">" [CFWS] / obs-angle-addr
+	group           =   display-name ":" [group-list] ";" [CFWS]
+	display-name    =   phrase
+
+	"Doe, John" <john@x.com>, team: a@b.c, d@e.f;, (comment) g@h.i
+
+	Empty list elements (obs-addr-list) and source routes (obs-route,
+	<@relay,@relay:john@x.com>) are accepted and skipped.
+
+*/
+
+namespace cm {
+namespace smtp {
+
+/**
+ * @class address_list
+ * @brief Parses an RFC 5322 address list, as in the To, Cc, Bcc and From headers
+ *
+ * Mailboxes are yielded one at a time by address_list::next(), as views into
+ * the input: nothing is copied nor allocated for valid input. Each addr-spec
+ * is checked with the smtp::address rules.
+ *
+ * A mailbox that breaks the address rules is still yielded, with its error.
+ * A list that breaks the RFC 5322 syntax stops the parsing.
+ * Caller must check the address_list::has_error() when next() returns false.
+ */
+class address_list : public error_check {
+
+	public:
+
+		/// A mailbox of the list
+		struct mailbox {
+			text_view   spec;     ///< The addr-spec
+			size_t      at;       ///< The '@' (at-sign) offset in the addr-spec
+			text_view   name;     ///< The display name, as written (quotes, comments), may be empty
+			text_view   group;    ///< The enclosing group display name, empty outside a group
+			const char *error;    ///< nullptr if the addr-spec is valid. Valid until the next call.
+
+			/// The local part
+			inline text_view local_part() const { return text_view(spec.data(), at); }
+
+			/// The domain
+			inline text_view domain() const { return text_view(spec.data() + at + 1, spec.size() - at - 1); }
+		};
+
+		/**
+		 * @brief Prepares the parsing of an address list
+		 *
+		 * @param in The header field body, kept by the caller while parsing
+		 * @param n  The size
+		 */
+		address_list(const char *in, size_t n) : _p(in), _n(n) {}
+
+		/// Convenience constructor
+		address_list(const std::string &in) : _p(in.data()), _n(in.size()) {}
+
+		/**
+		 * @brief Parses the next mailbox
+		 *
+		 * @param m The mailbox found
+		 *
+		 * @return false at the end of the list or on a syntax error.
+		 */
+		bool next(mailbox &m) {
+
+			while (! has_error()) {
+
+				skip_cfws();
+
+				if (_pos >= _n) {
+					if (_in_group)
+						return fail("Unfinished group");
+					return false;
+				}
+
+				char c = _p[_pos];
+
+				/* Empty list element */
+				if (c == ',') {
+					++_pos;
+					continue;
+				}
+
+				if (c == ';') {
+					if (! _in_group)
+						return fail("Group end outside a group");
+					++_pos;
+					_in_group = false;
+					_group = text_view();
+					if (! end_of_address())
+						return false;
+					continue;
+				}
+
+				size_t start = _pos;
+				size_t end = scan_phrase();
+
+				if (has_error())
+					return false;
+
+				c = ( _pos < _n ? _p[_pos] : ',' );
+
+				if (c == ':') {
+
+					if (_in_group)
+						return fail("Nested group");
+
+					if (end == start)
+						return fail("Group without a display name");
+
+					_group = text_view(_p + start, end - start);
+					_in_group = true;
+					++_pos;
+					continue;
+				}
+
+				if (c == '<') {
+
+					m.name = text_view(_p + start, end - start);
+
+					if (! scan_angle_addr(m))
+						return false;
+
+				} else {
+
+					/* addr-spec, the phrase scan stopped at a separator */
+					if (end == start)
+						return fail("Expected an address");
+
+					m.name = text_view();
+					m.spec = text_view(_p + start, end - start);
+				}
+
+				m.group = _group;
+				check(m);
+
+				if (! end_of_address())
+					return false;
+
+				return true;
+			}
+
+			return false;
+		}
+
+		/// The current offset in the input, the error position on a syntax error
+		inline size_t offset() const { return _pos; }
+
+	private:
+
+		enum char_class {
+			K_TEXT,      // atext, dots and '@', part of a word
+			K_WSP,       // space, tab, CR, LF
+			K_QUOTE,     // "
+			K_LPAREN,    // (
+			K_LBRACKET,  // [
+			K_LANGLE,    // <
+			K_STOP,      // , ; : end the phrase
+			K_BAD        // ) > ] \ and control characters
+		};
+
+		static inline char_class class_of(unsigned char c) {
+
+			static const struct table {
+
+				unsigned char c[256];
+
+				table() {
+					for (unsigned i = 0; i < 256; ++i)
+						c[i] = ( i < 0x20 || i == 0x7f ) ? K_BAD : K_TEXT;
+
+					c[static_cast<unsigned char>(' ')]  = K_WSP;
+					c[static_cast<unsigned char>('\t')] = K_WSP;
+					c[static_cast<unsigned char>('\r')] = K_WSP;
+					c[static_cast<unsigned char>('\n')] = K_WSP;
+					c[static_cast<unsigned char>('"')]  = K_QUOTE;
+					c[static_cast<unsigned char>('(')]  = K_LPAREN;
+					c[static_cast<unsigned char>('[')]  = K_LBRACKET;
+					c[static_cast<unsigned char>('<')]  = K_LANGLE;
+					c[static_cast<unsigned char>(',')]  = K_STOP;
+					c[static_cast<unsigned char>(';')]  = K_STOP;
+					c[static_cast<unsigned char>(':')]  = K_STOP;
+					c[static_cast<unsigned char>(')')]  = K_BAD;
+					c[static_cast<unsigned char>('>')]  = K_BAD;
+					c[static_cast<unsigned char>(']')]  = K_BAD;
+					c[static_cast<unsigned char>('\\')] = K_BAD;
+				}
+
+			} classes;
+
+			return static_cast<char_class>(classes.c[c]);
+		}
+
+		bool fail(const char *err) {
+			std::stringstream ss;
+			ss << err << " [pos: " << _pos << "]";
+			set_error(ss.str());
+			return false;
+		}
+
+		/* Skips white space, folding and nested comments */
+		void skip_cfws() {
+
+			while (_pos < _n) {
+
+				char_class k = class_of(static_cast<unsigned char>(_p[_pos]));
+
+				if (k == K_WSP) {
+					++_pos;
+					continue;
+				}
+
+				if (k != K_LPAREN)
+					return;
+
+				size_t depth = 0;
+
+				do {
+					char c = _p[_pos++];
+
+					if (c == '\\')
+						++_pos;
+					else if (c == '(')
+						++depth;
+					else if (c == ')')
+						--depth;
+
+				} while (depth && _pos < _n);
+
+				if (depth || _pos > _n) {
+					fail("Unfinished comment");
+					return;
+				}
+			}
+		}
+
+		/* Skips a quoted string or a domain literal, handling quoted pairs */
+		bool skip_delimited(char close) {
+
+			for (++_pos; _pos < _n; ++_pos) {
+
+				char c = _p[_pos];
+
+				if (c == '\\') {
+					++_pos;
+				} else if (c == close) {
+					++_pos;
+					return true;
+				}
+			}
+
+			return fail(close == '"' ? "Unfinished quoted string" : "Unfinished domain literal");
+		}
+
+		/*
+		 * Scans words up to a separator, returns the end of the last word.
+		 * Either a display name (then '<' or ':') or an addr-spec (then ',' ';' or the end).
+		 */
+		size_t scan_phrase() {
+
+			size_t end = _pos;
+
+			while (_pos < _n) {
+
+				switch (class_of(static_cast<unsigned char>(_p[_pos]))) {
+
+					case K_TEXT:
+						/* Tight loop, most bytes of a long list */
+						while (++_pos < _n && class_of(static_cast<unsigned char>(_p[_pos])) == K_TEXT)
+							;
+						end = _pos;
+						break;
+
+					case K_WSP:
+					case K_LPAREN:
+						skip_cfws();
+						if (has_error())
+							return end;
+						break;
+
+					case K_QUOTE:
+						if (! skip_delimited('"'))
+							return end;
+						end = _pos;
+						break;
+
+					case K_LBRACKET:
+						if (! skip_delimited(']'))
+							return end;
+						end = _pos;
+						break;
+
+					case K_LANGLE:
+					case K_STOP:
+						return end;
+
+					case K_BAD:
+						fail("Unexpected character");
+						return end;
+				}
+			}
+
+			return end;
+		}
+
+		/* Scans "<" [obs-route] addr-spec ">" */
+		bool scan_angle_addr(mailbox &m) {
+
+			++_pos;
+			skip_cfws();
+
+			/* obs-route: @relay,@relay: */
+			if (_pos < _n && _p[_pos] == '@') {
+				while (_pos < _n && _p[_pos] != ':' && _p[_pos] != '>')
+					++_pos;
+				if (_pos >= _n || _p[_pos] != ':')
+					return fail("Invalid source route");
+				++_pos;
+			}
+
+			skip_cfws();
+			size_t start = _pos;
+			size_t end = _pos;
+
+			while (_pos < _n && _p[_pos] != '>') {
+
+				char_class k = class_of(static_cast<unsigned char>(_p[_pos]));
+
+				if (k == K_QUOTE || k == K_LBRACKET) {
+					if (! skip_delimited(k == K_QUOTE ? '"' : ']'))
+						return false;
+					end = _pos;
+				} else if (k == K_WSP || k == K_LPAREN) {
+					skip_cfws();
+					if (has_error())
+						return false;
+				} else if (k == K_TEXT) {
+					end = ++_pos;
+				} else {
+					return fail("Unexpected character in angle address");
+				}
+			}
+
+			if (_pos >= _n)
+				return fail("Unfinished angle address");
+
+			++_pos;
+
+			/* <> is the null path, not a mailbox */
+			if (end == start)
+				return fail("Empty angle address");
+
+			m.spec = text_view(_p + start, end - start);
+
+			return true;
+		}
+
+		/* After a mailbox: CFWS then ',' ';' or the end */
+		bool end_of_address() {
+
+			skip_cfws();
+
+			if (has_error())
+				return false;
+
+			if (_pos >= _n)
+				return true;
+
+			if (_p[_pos] == ',') {
+				++_pos;
+				return true;
+			}
+
+			if (_p[_pos] == ';' && _in_group)
+				return true;
+
+			return fail("Expected a ',' (comma) between addresses");
+		}
+
+		void check(mailbox &m) {
+
+			_check.set_error(std::string());
+			m.at = address::check(m.spec.data(), m.spec.size(), _check);
+			m.error = _check.has_error() ? _check.error().c_str() : nullptr;
+
+			if (m.error)
+				m.at = 0;
+		}
+
+		const char * _p;
+		size_t       _n;
+		size_t       _pos = 0;
+		bool         _in_group = false;
+		text_view    _group;
+		error_check  _check;
+
+};
+
+}//namespace smtp
+}//namespace cm
+
+#endif //_CM_SMTP_ADDRESS_LIST_
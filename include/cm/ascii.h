@@ -0,0 +1,56 @@
+#ifndef _CM_ASCII_
+#define _CM_ASCII_
+
+#include <string>
+#include <cstddef>
+
+/*
+
+	ASCII case folding - domain names, schemes and header names compare
+	case-insensitively on the ASCII letters only (RFC 4343). The C tolower()
+	depends on the locale and is undefined for a negative char, so it is not
+	used on input bytes.
+
+*/
+
+namespace cm {
+namespace ascii {
+
+/// The lowercase of an ASCII letter, any other byte as it is
+inline char lower(char c) {
+	return ( c >= 'A' && c <= 'Z' ) ? static_cast<char>(c + 32) : c;
+}
+
+/// Lowercases the ASCII letters of a string, in place
+inline void lower(std::string &s) {
+	for (char &c : s)
+		c = lower(c);
+}
+
+/// Compares with a lowercase string, ignoring the case of the ASCII letters
+inline bool iequals(const char *p, size_t n, const std::string &lowercase) {
+
+	if (n != lowercase.size())
+		return false;
+
+	for (size_t i = 0; i < n; ++i)
+		if (lower(p[i]) != lowercase[i])
+			return false;
+
+	return true;
+}
+
+/// Compares n bytes of two strings, ignoring the case of the ASCII letters
+inline bool iequals(const char *a, const char *b, size_t n) {
+
+	for (size_t i = 0; i < n; ++i)
+		if (lower(a[i]) != lower(b[i]))
+			return false;
+
+	return true;
+}
+
+}//namespace ascii
+}//namespace cm
+
+#endif //_CM_ASCII_
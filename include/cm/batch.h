@@ -0,0 +1,128 @@
+#ifndef _CM_SMTP_BATCH_
+#define _CM_SMTP_BATCH_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/ascii.h>
+#include <cm/hash.h>
+#include <cm/smtp.h>
+
+namespace cm {
+namespace smtp {
+
+/**
+ * @class domain_batch
+ * @brief Validates a list of addresses and groups the valid ones by domain
+ *
+ * Grouping is a hash partition followed by a counting sort, O(n) overall. The
+ * input indexes of each domain are contiguous in indexes(), in input order;
+ * domains are in order of first appearance. Domains are compared case-folded.
+ *
+ *	cm::smtp::domain_batch b(recipients);
+ *	for (const auto &g : b.groups())
+ *		send(g.domain, b.indexes().data() + g.first, g.size);
+ */
+class domain_batch {
+
+	public:
+
+		/// The addresses of one domain
+		struct group {
+			std::string domain;  ///< The domain, case-folded
+			size_t      first;   ///< The first position in indexes()
+			size_t      size;    ///< The number of addresses
+		};
+
+		/**
+		 * @brief Validates and groups a list of addresses
+		 *
+		 * @param in The raw addresses
+		 */
+		domain_batch(const std::vector<std::string> &in) {
+
+			std::vector<uint32_t> group_of(in.size(), static_cast<uint32_t>(npos));
+
+			/* Power of two, at most half full even if every domain differs */
+			size_t cap = 16;
+			while (cap < in.size() * 2)
+				cap <<= 1;
+
+			std::vector<uint32_t> slots(cap, static_cast<uint32_t>(npos));
+			std::vector<uint64_t> hashes;
+
+			for (size_t i = 0; i < in.size(); ++i) {
+
+				address a(in[i]);
+
+				if (a.has_error()) {
+					_invalid.push_back(i);
+					continue;
+				}
+
+				address::domain_view d = a.get_domain();
+				uint64_t h = cm::hash::fnv1a64_lower(d.data(), d.size());
+
+				size_t pos = h & (cap - 1);
+
+				for (; slots[pos] != npos; pos = (pos + 1) & (cap - 1)) {
+
+					const std::string &other = _groups[slots[pos]].domain;
+
+					if (hashes[slots[pos]] == h && ascii::iequals(d.data(), d.size(), other))
+						break;
+				}
+
+				if (slots[pos] == npos) {
+					slots[pos] = static_cast<uint32_t>(_groups.size());
+					_groups.push_back(group{ d.canonical(), 0, 0 });
+					hashes.push_back(h);
+				}
+
+				group_of[i] = slots[pos];
+				++_groups[slots[pos]].size;
+			}
+
+			/* Counting sort of the input indexes by group */
+			size_t first = 0;
+			for (auto &g : _groups) {
+				g.first = first;
+				first += g.size;
+			}
+
+			_indexes.resize(first);
+
+			std::vector<size_t> next(_groups.size());
+			for (size_t g = 0; g < _groups.size(); ++g)
+				next[g] = _groups[g].first;
+
+			for (size_t i = 0; i < in.size(); ++i)
+				if (group_of[i] != npos)
+					_indexes[next[group_of[i]]++] = i;
+		}
+
+		/// The domains, in order of first appearance
+		inline const std::vector<group> & groups() const { return _groups; }
+
+		/// The input indexes of the valid addresses, contiguous per domain
+		inline const std::vector<size_t> & indexes() const { return _indexes; }
+
+		/// The input indexes of the invalid addresses
+		inline const std::vector<size_t> & invalid() const { return _invalid; }
+
+	private:
+
+		static constexpr uint32_t npos = 0xFFFFFFFF;
+
+		std::vector<group>  _groups;
+		std::vector<size_t> _indexes;
+		std::vector<size_t> _invalid;
+
+};
+
+}//namespace smtp
+}//namespace cm
+
+#endif //_CM_SMTP_BATCH_
@@ -0,0 +1,488 @@
+#ifndef _CM_SMTP_BLOCKLIST_
+#define _CM_SMTP_BLOCKLIST_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/ascii.h>
+#include <cm/hash.h>
+#include <cm/domain.h>
+#include <cm/mapped_file.h>
+#include <cm/smtp.h>
+
+/*
+
+	Xor filter - Graf, Lemire, "Xor Filters: Faster and Smaller Than Bloom
+	and Cuckoo Filters", 2020
+
+	Every key hashes to three slots, one in each third of the table, and its
+	8 bit fingerprint is the xor of the three slot values. A name that is not
+	in the list passes with a 1/256 probability; the name itself is then
+	compared with the list, so there are no false positives.
+
+	The table is about 1.23 bytes per name; it is built by peeling the slots
+	hit by a single key, with a new seed when the peeling fails.
+
+	Filter file - all integers are 32 bit little endian, 64 bit ones low half first
+
+	magic "CMDF" | version | seed (64 bit) | block_length | name_count | names_size
+	fingerprints[3 * block_length], zero padded to a multiple of 4
+	hashes[name_count] (64 bit), increasing
+	name offsets[name_count + 1] | names[names_size], in hash order
+
+	The file is used in place, nothing is rebuilt when loading.
+
+*/
+
+namespace cm {
+namespace smtp {
+
+/**
+ * @class domain_filter
+ * @brief Checks email domains against a list, as disposable mail providers
+ *
+ * Names are compared case-folded, without a final dot. A domain that is not in
+ * the list costs one hash and three byte loads; a listed one is confirmed by a
+ * binary search and a name comparison.
+ *
+ * The filter is immutable after being built or loaded; concurrent lookups are safe.
+ *
+ * Does not throw any exception when loading a filter file.
+ * Caller must check the domain_filter::has_error().
+ */
+class domain_filter : public error_check {
+
+	public:
+
+		typedef std::shared_ptr<domain_filter> ptr;
+
+		/**
+		 * @brief Builds the filter from a list of domains
+		 *
+		 * @param domains The domains (e.g. "mailinator.com"), duplicates allowed
+		 *
+		 * @throw dns::exceptions::invalid_domain if a name is not a valid domain
+		 */
+		domain_filter(const std::vector<std::string> &domains) {
+
+			std::vector<std::pair<uint64_t, std::string>> names;
+			names.reserve(domains.size());
+
+			for (const auto &d : domains) {
+
+				std::string name(d);
+
+				if (! name.empty() && name.back() == '.')
+					name.pop_back();
+
+				if (! dns::domain::is_ldh_name(name.data(), name.size()))
+					throw dns::exceptions::invalid_domain("Invalid domain name: " + d);
+
+				ascii::lower(name);
+
+				uint64_t h = cm::hash::fnv1a64_lower(name.data(), name.size());
+				names.emplace_back(h, std::move(name));
+			}
+
+			std::sort(names.begin(), names.end());
+			names.erase(std::unique(names.begin(), names.end()), names.end());
+
+			/* Equal hashes are one key for the filter, the names tell them apart */
+			std::vector<uint64_t> keys;
+			keys.reserve(names.size());
+
+			for (const auto &n : names)
+				if (keys.empty() || keys.back() != n.first)
+					keys.push_back(n.first);
+
+			std::vector<uint8_t> fingerprints;
+			uint64_t seed = 0;
+			uint32_t block_length = 0;
+
+			if (! keys.empty())
+				construct(keys, fingerprints, seed, block_length);
+
+			serialize(_owned, names, fingerprints, seed, block_length);
+			attach(reinterpret_cast<const unsigned char *>(_owned.data()), _owned.size());
+		}
+
+		/**
+		 * @brief Filter object factory method
+		 *
+		 * Maps and checks a filter file written by domain_filter::save().
+		 *
+		 * @param path The filter file path
+		 *
+		 * @return The shared pointer
+		 */
+		static ptr open(const std::string &path) {
+
+			ptr filter(new domain_filter(std::vector<std::string>()));
+
+			filter->_file.reset(new mapped_file(path));
+
+			if (filter->_file->has_error()) {
+				filter->set_error(*filter->_file);
+				return filter;
+			}
+
+			filter->_owned.clear();
+			filter->attach(reinterpret_cast<const unsigned char *>(filter->_file->data()), filter->_file->size());
+
+			if (filter->has_error())
+				filter->attach(nullptr, 0);
+
+			return filter;
+		}
+
+		/**
+		 * @brief Writes the filter to a file, to be loaded with domain_filter::open()
+		 *
+		 * @return false if the file could not be written.
+		 */
+		bool save(const std::string &path) const {
+			std::ofstream f(path, std::ios::binary | std::ios::trunc);
+			f.write(reinterpret_cast<const char *>(_data), static_cast<std::streamsize>(_size));
+			return static_cast<bool>(f);
+		}
+
+		/**
+		 * @brief Checks if a domain is in the list
+		 *
+		 * @param p The domain first byte
+		 * @param n The domain size
+		 */
+		bool contains(const char *p, size_t n) const {
+
+			if (n && p[n - 1] == '.')
+				--n;
+
+			if (_count == 0 || n == 0 || n > dns::domain::max_name_size)
+				return false;
+
+			uint64_t key = cm::hash::fnv1a64_lower(p, n);
+
+			if (! maybe(key))
+				return false;
+
+			return confirm(key, p, n);
+		}
+
+		/// Convenience overload
+		inline bool contains(const std::string &domain) const {
+			return contains(domain.data(), domain.size());
+		}
+
+		/**
+		 * @brief Checks if a domain or one of its parents is in the list
+		 *
+		 * With "mailinator.com" listed, "eu.mailinator.com" matches.
+		 *
+		 * @param p The domain first byte
+		 * @param n The domain size
+		 */
+		bool matches(const char *p, size_t n) const {
+
+			if (n && p[n - 1] == '.')
+				--n;
+
+			for (size_t i = 0; i < n; ++i) {
+
+				if (i == 0 || p[i - 1] == '.')
+					if (contains(p + i, n - i))
+						return true;
+			}
+
+			return false;
+		}
+
+		/**
+		 * @brief Checks if the domain of a valid address or one of its parents is in the list
+		 *
+		 * @return false if the address has an error or a domain literal.
+		 */
+		bool matches(const address &a) const {
+
+			if (a.has_error())
+				return false;
+
+			address::domain_view d = a.get_domain();
+
+			if (d.is_literal())
+				return false;
+
+			return matches(d.data(), d.size());
+		}
+
+		/// The number of distinct names
+		inline size_t size() const { return _count; }
+
+	private:
+
+		/* Points into its own buffer */
+		domain_filter(const domain_filter &) = delete;
+		domain_filter & operator=(const domain_filter &) = delete;
+
+		static constexpr uint32_t version = 1;
+		static constexpr size_t   header_size = 28;
+
+		/* Maps a 32 bit value to [0, n) without a division */
+		static inline uint32_t reduce(uint32_t x, uint32_t n) {
+			return static_cast<uint32_t>(( static_cast<uint64_t>(x) * n ) >> 32);
+		}
+
+		static inline uint8_t fingerprint(uint64_t h) {
+			return static_cast<uint8_t>(h ^ ( h >> 32 ));
+		}
+
+		static inline uint32_t slot(uint64_t h, int i, uint32_t block_length) {
+			return reduce(static_cast<uint32_t>(cm::hash::rotl64(h, 21 * i)), block_length) + i * block_length;
+		}
+
+		static void put(std::string &out, uint64_t v) {
+			for (int i = 0; i < 4; ++i)
+				out += static_cast<char>((v >> (8 * i)) & 0xFF);
+		}
+
+		static uint32_t get(const unsigned char *p) {
+			return   static_cast<uint32_t>(p[0])
+			       | static_cast<uint32_t>(p[1]) << 8
+			       | static_cast<uint32_t>(p[2]) << 16
+			       | static_cast<uint32_t>(p[3]) << 24;
+		}
+
+		static inline uint64_t get64(const unsigned char *p) {
+			return get(p) | static_cast<uint64_t>(get(p + 4)) << 32;
+		}
+
+		/* Peels the keys, with a new seed until every key owns a slot */
+		static void construct(const std::vector<uint64_t> &keys, std::vector<uint8_t> &fingerprints,
+				uint64_t &seed, uint32_t &block_length) {
+
+			size_t n = keys.size();
+			block_length = static_cast<uint32_t>(( 32 + n * 123 / 100 ) / 3 + 1);
+			size_t cap = 3 * static_cast<size_t>(block_length);
+
+			std::vector<uint32_t> count(cap);
+			std::vector<uint64_t> xors(cap);
+			std::vector<uint32_t> queue;
+			std::vector<std::pair<uint64_t, uint32_t>> stack;
+
+			queue.reserve(cap);
+			stack.reserve(n);
+
+			for (seed = 0x9E3779B97F4A7C15ULL; ; seed += 0x9E3779B97F4A7C15ULL) {
+
+				std::fill(count.begin(), count.end(), 0);
+				std::fill(xors.begin(), xors.end(), 0);
+				queue.clear();
+				stack.clear();
+
+				for (uint64_t k : keys) {
+					uint64_t h = cm::hash::fmix64(k + seed);
+					for (int i = 0; i < 3; ++i) {
+						uint32_t s = slot(h, i, block_length);
+						++count[s];
+						xors[s] ^= h;
+					}
+				}
+
+				for (uint32_t s = 0; s < cap; ++s)
+					if (count[s] == 1)
+						queue.push_back(s);
+
+				while (! queue.empty()) {
+
+					uint32_t s = queue.back();
+					queue.pop_back();
+
+					if (count[s] != 1)
+						continue;
+
+					uint64_t h = xors[s];
+					stack.emplace_back(h, s);
+
+					for (int i = 0; i < 3; ++i) {
+						uint32_t o = slot(h, i, block_length);
+						xors[o] ^= h;
+						if (--count[o] == 1)
+							queue.push_back(o);
+					}
+				}
+
+				if (stack.size() == n)
+					break;
+			}
+
+			fingerprints.assign(cap, 0);
+
+			for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+
+				uint64_t h = it->first;
+				uint8_t f = fingerprint(h);
+
+				for (int i = 0; i < 3; ++i) {
+					uint32_t o = slot(h, i, block_length);
+					if (o != it->second)
+						f ^= fingerprints[o];
+				}
+
+				fingerprints[it->second] = f;
+			}
+		}
+
+		static void serialize(std::string &out, const std::vector<std::pair<uint64_t, std::string>> &names,
+				const std::vector<uint8_t> &fingerprints, uint64_t seed, uint32_t block_length) {
+
+			size_t names_size = 0;
+			for (const auto &n : names)
+				names_size += n.second.size();
+
+			out.assign("CMDF");
+			put(out, version);
+			put(out, seed & 0xFFFFFFFF);
+			put(out, seed >> 32);
+			put(out, block_length);
+			put(out, names.size());
+			put(out, names_size);
+
+			out.append(reinterpret_cast<const char *>(fingerprints.data()), fingerprints.size());
+			out.append(( 4 - fingerprints.size() % 4 ) % 4, '\0');
+
+			for (const auto &n : names) {
+				put(out, n.first & 0xFFFFFFFF);
+				put(out, n.first >> 32);
+			}
+
+			size_t offset = 0;
+			put(out, offset);
+			for (const auto &n : names)
+				put(out, offset += n.second.size());
+
+			for (const auto &n : names)
+				out += n.second;
+		}
+
+		/* Points into a serialized filter, in memory or mapped */
+		void attach(const unsigned char *p, size_t size) {
+
+			_data = p;
+			_size = size;
+			_count = 0;
+			_block_length = 0;
+
+			if (p == nullptr)
+				return;
+
+			error_check_assert(size < header_size || std::memcmp(p, "CMDF", 4) != 0, "Not a domain filter file.");
+			error_check_assert(get(p + 4) != version, "Unsupported domain filter version.");
+
+			uint64_t seed         = get64(p + 8);
+			size_t   block_length = get(p + 16);
+			size_t   count        = get(p + 20);
+			size_t   names_size   = get(p + 24);
+
+			uint64_t fp_size = ( 3 * static_cast<uint64_t>(block_length) + 3 ) / 4 * 4;
+
+			/* 64 bit sums cannot overflow */
+			uint64_t need = header_size + fp_size + 8 * static_cast<uint64_t>(count)
+			              + 4 * ( static_cast<uint64_t>(count) + 1 ) + names_size;
+
+			error_check_assert(need != size, "Invalid domain filter size.");
+			error_check_assert(( count == 0 ) != ( block_length == 0 ), "Invalid domain filter table.");
+
+			const unsigned char *hashes  = p + header_size + fp_size;
+			const unsigned char *offsets = hashes + 8 * count;
+
+			for (size_t i = 0; i < count; ++i) {
+
+				error_check_assert(i && get64(hashes + 8 * i) < get64(hashes + 8 * ( i - 1 )),
+						"Invalid domain filter hash order.");
+
+				size_t from = get(offsets + 4 * i);
+				size_t to = get(offsets + 4 * i + 4);
+
+				error_check_assert(from > to || to > names_size || to - from > dns::domain::max_name_size,
+						"Invalid domain filter name.");
+			}
+
+			_seed         = seed;
+			_block_length = static_cast<uint32_t>(block_length);
+			_fingerprints = p + header_size;
+			_hashes       = hashes;
+			_offsets      = offsets;
+			_names        = reinterpret_cast<const char *>(offsets + 4 * ( count + 1 ));
+			_count        = count;
+		}
+
+		inline bool maybe(uint64_t key) const {
+
+			uint64_t h = cm::hash::fmix64(key + _seed);
+			uint8_t f = fingerprint(h);
+
+			f ^= _fingerprints[slot(h, 0, _block_length)];
+			f ^= _fingerprints[slot(h, 1, _block_length)];
+			f ^= _fingerprints[slot(h, 2, _block_length)];
+
+			return f == 0;
+		}
+
+		/* Binary search of the hash, then the names with that hash */
+		bool confirm(uint64_t key, const char *p, size_t n) const {
+
+			size_t lo = 0;
+			size_t hi = _count;
+
+			while (lo < hi) {
+				size_t mid = lo + ( hi - lo ) / 2;
+				if (get64(_hashes + 8 * mid) < key)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+
+			for (; lo < _count && get64(_hashes + 8 * lo) == key; ++lo) {
+
+				size_t from = get(_offsets + 4 * lo);
+				size_t to = get(_offsets + 4 * lo + 4);
+
+				if (to - from != n)
+					continue;
+
+				size_t i = 0;
+				while (i < n && ascii::lower(p[i]) == _names[from + i])
+					++i;
+
+				if (i == n)
+					return true;
+			}
+
+			return false;
+		}
+
+		std::string                  _owned;
+		std::unique_ptr<mapped_file> _file;
+
+		const unsigned char * _data = nullptr;
+		size_t                _size = 0;
+
+		uint64_t              _seed = 0;
+		uint32_t              _block_length = 0;
+		const unsigned char * _fingerprints = nullptr;
+		const unsigned char * _hashes = nullptr;
+		const unsigned char * _offsets = nullptr;
+		const char *          _names = nullptr;
+		size_t                _count = 0;
+
+};
+
+}//namespace smtp
+}//namespace cm
+
+#endif //_CM_SMTP_BLOCKLIST_
@@ -0,0 +1,234 @@
+#ifndef _CM_SMTP_CANONICAL_
+#define _CM_SMTP_CANONICAL_
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/ascii.h>
+#include <cm/hash.h>
+#include <cm/smtp.h>
+
+/*
+
+	Local part equivalence - http://tools.ietf.org/html/rfc5321#section-4.1.2
+
+	A quoted string and its dot-atom form are the same local part when the
+	content needs no quoting: "john.doe"@example.com is john.doe@example.com.
+	Addresses with comments are not valid (see smtp.h), so there are none to
+	remove.
+
+	The canonical form keeps the value of the local part, quoted only if it
+	must be, and the lowercase domain. Provider rules may then map mailboxes
+	that are delivered to the same account to one form.
+
+	Fingerprint - MurmurHash3 x64 128, see cm/hash.h
+
+*/
+
+namespace cm {
+namespace smtp {
+
+/**
+ * @brief Rules applied by the canonicaliser
+ */
+struct canonical_options {
+
+	/// Gmail rules: no dots, no "+tag", lowercase and googlemail.com is gmail.com
+	bool provider_rules  = true;
+
+	/// Removes a "+tag" suffix of the local part, for every domain
+	bool strip_tags      = false;
+
+	/// Lowercases the local part, for every domain
+	bool lowercase_local = false;
+};
+
+/// A 128 bit address fingerprint
+typedef cm::fingerprint128 fingerprint128;
+
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+/* A dot-atom needs no quoting */
+inline bool is_dot_atom(const char *p, size_t n) {
+
+	if (n == 0 || p[0] == '.' || p[n - 1] == '.')
+		return false;
+
+	for (size_t i = 0; i < n; ++i) {
+
+		if (p[i] == '.') {
+			if (p[i - 1] == '.')
+				return false;
+			continue;
+		}
+
+		if (! local_part::is_atext(static_cast<unsigned char>(p[i])))
+			return false;
+	}
+
+	return true;
+}
+
+/* Appends the value of a local part: no quotes, no escapes */
+inline void local_value(const char *p, size_t n, std::string &out) {
+
+	bool quoted = false;
+
+	for (size_t i = 0; i < n; ++i) {
+
+		char c = p[i];
+
+		if (quoted) {
+			if (c == '\\' && i + 1 < n)
+				out += p[++i];
+			else if (c == '"')
+				quoted = false;
+			else
+				out += c;
+			continue;
+		}
+
+		if (c == '"')
+			quoted = true;
+		else
+			out += c;
+	}
+}
+
+} //namespace details
+/// @endcond
+
+/**
+ * @brief Writes the canonical form of a valid address
+ *
+ * A plain address (not quoted) is copied as is; a quoted one has its quotes
+ * removed when not needed. The domain is lowercased and the options applied.
+ *
+ * @param a   The address
+ * @param out The canonical form. Reusing it avoids allocations.
+ * @param opt The rules
+ *
+ * @return false if the address has an error.
+ */
+inline bool canonicalize(const address &a, std::string &out, const canonical_options &opt = canonical_options()) {
+
+	out.clear();
+
+	if (a.has_error())
+		return false;
+
+	address::local_part_view lp = a.get_local_part();
+	address::domain_view dp = a.get_domain();
+
+	if (lp.is_quoted())
+		details::local_value(lp.data(), lp.size(), out);
+	else
+		out.append(lp.data(), lp.size());
+
+	size_t at = out.size();
+	out += '@';
+	out.append(dp.data(), dp.size());
+
+	for (size_t i = at + 1; i < out.size(); ++i)
+		out[i] = ascii::lower(out[i]);
+
+	const char *domain = out.data() + at + 1;
+	size_t domain_size = out.size() - at - 1;
+
+	bool gmail = opt.provider_rules &&
+		( ( domain_size == 9 && std::memcmp(domain, "gmail.com", 9) == 0 ) ||
+		  ( domain_size == 14 && std::memcmp(domain, "googlemail.com", 14) == 0 ) );
+
+	if (gmail)
+		out.replace(at + 1, std::string::npos, "gmail.com");
+
+	if (gmail || opt.strip_tags) {
+		size_t plus = out.find('+');
+		if (plus != std::string::npos && plus < at && plus > 0) {
+			out.erase(plus, at - plus);
+			at = plus;
+		}
+	}
+
+	if (gmail) {
+		size_t w = 0;
+		for (size_t r = 0; r < at; ++r)
+			if (out[r] != '.')
+				out[w++] = out[r];
+		out.erase(w, at - w);
+		at = w;
+	}
+
+	if (gmail || opt.lowercase_local)
+		for (size_t i = 0; i < at; ++i)
+			out[i] = ascii::lower(out[i]);
+
+	if (details::is_dot_atom(out.data(), at))
+		return true;
+
+	/* Quoted string, escaping quotes and backslashes */
+	std::string quoted("\"");
+
+	for (size_t i = 0; i < at; ++i) {
+		if (out[i] == '"' || out[i] == '\\')
+			quoted += '\\';
+		quoted += out[i];
+	}
+
+	quoted += '"';
+	out.replace(0, at, quoted);
+
+	return true;
+}
+
+/**
+ * @brief Gets the canonical form of a valid address
+ *
+ * @return The canonical form, empty if the address has an error.
+ */
+inline std::string canonical(const address &a, const canonical_options &opt = canonical_options()) {
+	std::string out;
+	canonicalize(a, out, opt);
+	return out;
+}
+
+/**
+ * @brief Gets the 128 bit fingerprint of the canonical form of an address
+ *
+ * Equal canonical forms give equal fingerprints.
+ *
+ * @param a       The address
+ * @param scratch A reusable buffer for the canonical form
+ * @param opt     The rules
+ *
+ * @return The fingerprint, zero if the address has an error.
+ */
+inline fingerprint128 fingerprint(const address &a, std::string &scratch, const canonical_options &opt = canonical_options()) {
+
+	if (! canonicalize(a, scratch, opt))
+		return fingerprint128();
+
+	return hash::murmur3_128(scratch.data(), scratch.size());
+}
+
+/// Convenience overload
+inline fingerprint128 fingerprint(const address &a, const canonical_options &opt = canonical_options()) {
+	std::string scratch;
+	return fingerprint(a, scratch, opt);
+}
+
+/**
+ * @brief Gets the 64 bit fingerprint of the canonical form of an address
+ *
+ * @return The fingerprint, zero if the address has an error.
+ */
+inline uint64_t fingerprint64(const address &a, std::string &scratch, const canonical_options &opt = canonical_options()) {
+	return fingerprint(a, scratch, opt).lo;
+}
+
+}//namespace smtp
+}//namespace cm
+
+#endif //_CM_SMTP_CANONICAL_
@@ -8,11 +8,35 @@
  */
 
 #include <cm/validator.h>
+#include <cm/ascii.h>
+#include <cm/hash.h>
+#include <cm/text_view.h>
 #include <cm/stopwatch.h>
 
 #include <cm/domain.h>
+#include <cm/confusable.h>
+#include <cm/zone.h>
+#include <cm/wire.h>
+#include <cm/message.h>
+#include <cm/tls.h>
 #include <cm/smtp.h>
+#include <cm/typo.h>
+#include <cm/canonical.h>
+#include <cm/batch.h>
+#include <cm/blocklist.h>
+#include <cm/address_list.h>
+#include <cm/header.h>
+#include <cm/extract.h>
+#include <cm/command.h>
+#include <cm/decode.h>
+#include <cm/sketch.h>
+#include <cm/cuckoo.h>
 #include <cm/url.h>
+#include <cm/url_view.h>
+#include <cm/url_normalize.h>
+#include <cm/url_query.h>
+#include <cm/url_fingerprint.h>
+#include <cm/url_resolve.h>
 #include <cm/media.h>
 
 #include <cm/uuid.h>
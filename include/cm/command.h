@@ -0,0 +1,346 @@
+#ifndef _CM_SMTP_COMMAND_
+#define _CM_SMTP_COMMAND_
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/ascii.h>
+#include <cm/domain.h>
+#include <cm/smtp.h>
+
+/*
+
+	SMTP commands - http://tools.ietf.org/html/rfc5321#section-4.1.2
+
+	mail            = "MAIL FROM:" Reverse-path [SP Mail-parameters] CRLF
+	rcpt            = "RCPT TO:" ( "<Postmaster@" Domain ">" / "<Postmaster>" /
+	                  Forward-path ) [SP Rcpt-parameters] CRLF
+
+	Reverse-path    = Path / "<>"
+	Forward-path    = Path
+	Path            = "<" [ A-d-l ":" ] Mailbox ">"
+	A-d-l           = At-domain *( "," At-domain )  ; source route, to be ignored
+	At-domain       = "@" Domain
+
+	esmtp-param     = esmtp-keyword ["=" esmtp-value]
+	esmtp-keyword   = (ALPHA / DIGIT) *(ALPHA / DIGIT / "-")
+	esmtp-value     = 1*(%d33-60 / %d62-126)  ; UTF-8 too, with SMTPUTF8
+
+	MAIL FROM:<john@example.com> SIZE=1000 BODY=8BITMIME
+	RCPT TO:<@relay.net:mary@example.com> NOTIFY=SUCCESS,FAILURE
+
+*/
+
+namespace cm {
+namespace smtp {
+
+/**
+ * @class command
+ * @brief Parses the MAIL FROM and RCPT TO command lines
+ *
+ * The path and the parameters are views into the line, which the caller keeps
+ * while using them. One instance is meant to be reused for every command of a
+ * connection: parsing a valid line allocates nothing.
+ *
+ *	cm::smtp::command cmd;
+ *	if (cmd.parse(line, size) && cmd.find("SIZE"))
+ *		...
+ *
+ * A space after the colon, as sent by some clients, is accepted. Verbs and
+ * keywords are case-insensitive.
+ *
+ * Does not throw any exception in case of invalid input.
+ * Caller must check the command::has_error().
+ */
+class command : public error_check {
+
+	public:
+
+		/// The command verb
+		enum verb_type {
+			NONE,
+			MAIL,  ///< MAIL FROM
+			RCPT   ///< RCPT TO
+		};
+
+		/// An ESMTP parameter
+		struct parameter {
+			text_view keyword;  ///< The keyword
+			text_view value;    ///< The value, empty if none
+		};
+
+		/// Maximum number of parameters of a command
+		static constexpr size_t max_params = 16;
+
+		/// An empty command
+		command() {}
+
+		/**
+		 * @brief Parses a command line
+		 *
+		 * @param in The line, with or without the final CRLF
+		 * @param n  The size
+		 */
+		command(const char *in, size_t n) { parse(in, n); }
+
+		/**
+		 * @brief Parses a command line, replacing the previous one
+		 *
+		 * @param in The line, with or without the final CRLF
+		 * @param n  The size
+		 *
+		 * @return false if the line has an error.
+		 */
+		bool parse(const char *in, size_t n) {
+
+			_err.clear();
+			reset();
+
+			if (n && in[n - 1] == '\n')
+				--n;
+			if (n && in[n - 1] == '\r')
+				--n;
+
+			size_t pos;
+
+			if (prefix(in, n, "MAIL FROM:")) {
+				_verb = MAIL;
+				pos = 10;
+			} else if (prefix(in, n, "RCPT TO:")) {
+				_verb = RCPT;
+				pos = 8;
+			} else {
+				return fail("Unknown command");
+			}
+
+			if (pos < n && in[pos] == ' ')
+				++pos;
+
+			if (! parse_path(in, n, pos))
+				return false;
+
+			while (pos < n) {
+
+				if (in[pos] != ' ')
+					return fail("Expected a ' ' (space) before a parameter");
+
+				while (pos < n && in[pos] == ' ')
+					++pos;
+
+				if (pos < n && ! parse_param(in, n, pos))
+					return false;
+			}
+
+			return true;
+		}
+
+		/// The command verb, NONE on error. Nothing else is kept on error.
+		inline verb_type verb() const { return _verb; }
+
+		/// The mailbox, empty for the null path
+		inline const text_view & path() const { return _path; }
+
+		/// The '@' (at-sign) offset in the mailbox, 0 for the null path or Postmaster
+		inline size_t at() const { return _at; }
+
+		/// The source route, without its ':' (colon), empty if none
+		inline const text_view & route() const { return _route; }
+
+		/// Checks if the path is the null path <>
+		inline bool is_null() const { return _verb == MAIL && _path.empty(); }
+
+		/// Checks if the path is <Postmaster>, without a domain
+		inline bool is_postmaster() const { return _postmaster; }
+
+		/// The number of parameters
+		inline size_t params() const { return _count; }
+
+		/// A parameter, by position
+		inline const parameter & param(size_t i) const { return _params[i]; }
+
+		/**
+		 * @brief Finds a parameter, case-insensitive
+		 *
+		 * @param keyword The keyword, as a C string
+		 *
+		 * @return The parameter, nullptr if not found.
+		 */
+		const parameter * find(const char *keyword) const {
+
+			size_t n = std::strlen(keyword);
+
+			for (size_t i = 0; i < _count; ++i)
+				if (_params[i].keyword.size() == n && ascii::iequals(_params[i].keyword.data(), keyword, n))
+					return &_params[i];
+
+			return nullptr;
+		}
+
+	private:
+
+		static bool prefix(const char *in, size_t n, const char *verb) {
+			size_t len = std::strlen(verb);
+			return n >= len && ascii::iequals(in, verb, len);
+		}
+
+		static inline bool is_alnum(char c) {
+			return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' );
+		}
+
+		static inline bool is_value_char(char c) {
+			unsigned char u = static_cast<unsigned char>(c);
+			return ( u >= 33 && u <= 126 && u != '=' ) || u > 0x7f;
+		}
+
+		void reset() {
+			_verb = NONE;
+			_path = text_view();
+			_route = text_view();
+			_at = 0;
+			_postmaster = false;
+			_count = 0;
+		}
+
+		/* Nothing but the error is kept */
+		bool fail(const std::string &err) {
+			set_error(err);
+			reset();
+			return false;
+		}
+
+		/* Path = "<" [ A-d-l ":" ] Mailbox ">" / "<>" */
+		bool parse_path(const char *in, size_t n, size_t &pos) {
+
+			if (pos >= n || in[pos] != '<')
+				return fail("Missing path '<' (less-than) delimiter");
+
+			++pos;
+
+			/* Source route */
+			if (pos < n && in[pos] == '@') {
+
+				size_t start = pos;
+
+				for (;;) {
+
+					size_t domain = ++pos;
+
+					while (pos < n && in[pos] != ',' && in[pos] != ':' && in[pos] != '>')
+						++pos;
+
+					if (! dns::domain::is_ldh_name(in + domain, pos - domain))
+						return fail("Invalid source route domain");
+
+					if (pos >= n || in[pos] == '>')
+						return fail("Missing source route ':' (colon) delimiter");
+
+					if (in[pos] == ':')
+						break;
+
+					/* , */
+					if (++pos >= n || in[pos] != '@')
+						return fail("Invalid source route");
+				}
+
+				_route = text_view(in + start, pos - start);
+				++pos;
+			}
+
+			const char *close = static_cast<const char *>(std::memchr(in + pos, '>', n - pos));
+
+			/* A '>' inside a quoted local part is not the end */
+			if (close && pos < n && in[pos] == '"') {
+
+				size_t i = pos + 1;
+
+				for (; i < n && in[i] != '"'; ++i)
+					if (in[i] == '\\')
+						++i;
+
+				close = i < n ? static_cast<const char *>(std::memchr(in + i, '>', n - i)) : nullptr;
+			}
+
+			if (! close)
+				return fail("Missing path '>' (greater-than) delimiter");
+
+			size_t end = static_cast<size_t>(close - in);
+
+			_path = text_view(in + pos, end - pos);
+			pos = end + 1;
+
+			if (_path.empty()) {
+				if (_verb == RCPT || ! _route.empty())
+					return fail("Null path not allowed");
+				return true;
+			}
+
+			if (_verb == RCPT && _path.size() == 10 && ascii::iequals(_path.data(), "Postmaster", 10)) {
+				_postmaster = true;
+				return true;
+			}
+
+			_check.set_error(std::string());
+			_at = address::check(_path.data(), _path.size(), _check);
+
+			if (_check.has_error())
+				return fail("Invalid path: " + _check.error());
+
+			return true;
+		}
+
+		/* esmtp-param = esmtp-keyword ["=" esmtp-value] */
+		bool parse_param(const char *in, size_t n, size_t &pos) {
+
+			if (_count == max_params)
+				return fail("Too many parameters");
+
+			size_t start = pos;
+
+			if (! is_alnum(in[pos]))
+				return fail("Invalid parameter keyword");
+
+			while (pos < n && ( is_alnum(in[pos]) || in[pos] == '-' ))
+				++pos;
+
+			parameter &p = _params[_count];
+			p.keyword = text_view(in + start, pos - start);
+			p.value = text_view();
+
+			if (pos < n && in[pos] == '=') {
+
+				start = ++pos;
+
+				while (pos < n && is_value_char(in[pos]))
+					++pos;
+
+				if (pos == start)
+					return fail("Empty parameter value");
+
+				p.value = text_view(in + start, pos - start);
+			}
+
+			if (pos < n && in[pos] != ' ')
+				return fail("Invalid parameter character");
+
+			++_count;
+
+			return true;
+		}
+
+		verb_type    _verb = NONE;
+		text_view    _path;
+		text_view    _route;
+		size_t       _at = 0;
+		bool         _postmaster = false;
+		parameter    _params[max_params];
+		size_t       _count = 0;
+		error_check  _check;
+
+};
+
+}//namespace smtp
+}//namespace cm
+
+#endif //_CM_SMTP_COMMAND_
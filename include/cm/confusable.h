@@ -0,0 +1,871 @@
+#ifndef _CM_CONFUSABLE_
+#define _CM_CONFUSABLE_
+
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <cm/validator.h>
+#include <cm/ascii.h>
+#include <cm/hash.h>
+#include <cm/domain.h>
+
+/*
+
+	Unicode Technical Standard #39 - Unicode Security Mechanisms
+
+	http://www.unicode.org/reports/tr39/#Confusable_Detection
+	http://www.unicode.org/reports/tr39/#Restriction_Level_Detection
+	http://tools.ietf.org/html/rfc3492  (Punycode)
+
+	Two strings X and Y are confusable when skeleton(X) == skeleton(Y).
+
+	The skeleton tables below are a precompiled subset of confusables.txt,
+	restricted to characters that imitate the letters, digits and hyphen allowed
+	in a host name. Since domain names compare case-insensitively, ASCII is
+	lowercased first and every target is stored already lowercased and already
+	in skeleton form, so one table lookup per code point is enough.
+
+*/
+
+namespace cm {
+namespace dns {
+
+namespace exceptions {
+
+/**
+ * @class mixed_script_domain
+ * @brief An exception class to indicate that a domain name mixes scripts beyond the
+ *        UTS #39 highly restrictive profile.
+ */
+class mixed_script_domain : public std::invalid_argument {
+	// C++11 inheriting constructors
+	using invalid_argument::invalid_argument;
+};
+
+} //namespace exceptions
+
+/// The scripts recognized by the mixed-script detection
+enum script {
+	COMMON = 0,
+	INHERITED = 1,
+	LATIN = 2,
+	GREEK = 3,
+	CYRILLIC = 4,
+	ARMENIAN = 5,
+	HEBREW = 6,
+	ARABIC = 7,
+	DEVANAGARI = 8,
+	THAI = 9,
+	GEORGIAN = 10,
+	HANGUL = 11,
+	HIRAGANA = 12,
+	KATAKANA = 13,
+	BOPOMOFO = 14,
+	HAN = 15,
+	OTHER = 16
+};
+
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+/* Code point range to script */
+struct script_range {
+	char32_t first;
+	char32_t last;
+	script   value;
+};
+
+/* Sorted by first code point. Gaps are OTHER. */
+constexpr static const script_range script_ranges[] = {
+	{ 0x0000,  0x0040,  COMMON     },
+	{ 0x0041,  0x005A,  LATIN      },
+	{ 0x005B,  0x0060,  COMMON     },
+	{ 0x0061,  0x007A,  LATIN      },
+	{ 0x007B,  0x00BF,  COMMON     },
+	{ 0x00C0,  0x00D6,  LATIN      },
+	{ 0x00D7,  0x00D7,  COMMON     },
+	{ 0x00D8,  0x00F6,  LATIN      },
+	{ 0x00F7,  0x00F7,  COMMON     },
+	{ 0x00F8,  0x02AF,  LATIN      },
+	{ 0x02B0,  0x02FF,  COMMON     },
+	{ 0x0300,  0x036F,  INHERITED  },
+	{ 0x0370,  0x03FF,  GREEK      },
+	{ 0x0400,  0x052F,  CYRILLIC   },
+	{ 0x0530,  0x058F,  ARMENIAN   },
+	{ 0x0590,  0x05FF,  HEBREW     },
+	{ 0x0600,  0x06FF,  ARABIC     },
+	{ 0x0750,  0x077F,  ARABIC     },
+	{ 0x08A0,  0x08FF,  ARABIC     },
+	{ 0x0900,  0x097F,  DEVANAGARI },
+	{ 0x0E00,  0x0E7F,  THAI       },
+	{ 0x10A0,  0x10FF,  GEORGIAN   },
+	{ 0x1100,  0x11FF,  HANGUL     },
+	{ 0x1AB0,  0x1AFF,  INHERITED  },
+	{ 0x1D00,  0x1D7F,  LATIN      },
+	{ 0x1DC0,  0x1DFF,  INHERITED  },
+	{ 0x1E00,  0x1EFF,  LATIN      },
+	{ 0x1F00,  0x1FFF,  GREEK      },
+	{ 0x2000,  0x20CF,  COMMON     },
+	{ 0x20D0,  0x20FF,  INHERITED  },
+	{ 0x2100,  0x2BFF,  COMMON     },
+	{ 0x2C60,  0x2C7F,  LATIN      },
+	{ 0x2DE0,  0x2DFF,  CYRILLIC   },
+	{ 0x3000,  0x303F,  COMMON     },
+	{ 0x3040,  0x3098,  HIRAGANA   },
+	{ 0x3099,  0x309A,  INHERITED  },
+	{ 0x309B,  0x309C,  COMMON     },
+	{ 0x309D,  0x309F,  HIRAGANA   },
+	{ 0x30A0,  0x30FB,  KATAKANA   },
+	{ 0x30FC,  0x30FC,  COMMON     },
+	{ 0x30FD,  0x30FF,  KATAKANA   },
+	{ 0x3100,  0x312F,  BOPOMOFO   },
+	{ 0x3130,  0x318F,  HANGUL     },
+	{ 0x31A0,  0x31BF,  BOPOMOFO   },
+	{ 0x31F0,  0x31FF,  KATAKANA   },
+	{ 0x3400,  0x4DBF,  HAN        },
+	{ 0x4E00,  0x9FFF,  HAN        },
+	{ 0xA640,  0xA69F,  CYRILLIC   },
+	{ 0xA720,  0xA7FF,  LATIN      },
+	{ 0xAC00,  0xD7AF,  HANGUL     },
+	{ 0xF900,  0xFAFF,  HAN        },
+	{ 0xFB00,  0xFB06,  LATIN      },
+	{ 0xFB1D,  0xFB4F,  HEBREW     },
+	{ 0xFB50,  0xFDFF,  ARABIC     },
+	{ 0xFE00,  0xFE0F,  INHERITED  },
+	{ 0xFE20,  0xFE2F,  INHERITED  },
+	{ 0xFE30,  0xFE6F,  COMMON     },
+	{ 0xFE70,  0xFEFF,  ARABIC     },
+	{ 0xFF00,  0xFF20,  COMMON     },
+	{ 0xFF21,  0xFF3A,  LATIN      },
+	{ 0xFF3B,  0xFF40,  COMMON     },
+	{ 0xFF41,  0xFF5A,  LATIN      },
+	{ 0xFF5B,  0xFF65,  COMMON     },
+	{ 0xFF66,  0xFF9F,  KATAKANA   },
+	{ 0x1D400, 0x1D7FF, COMMON     },
+	{ 0x20000, 0x2FA1F, HAN        }
+};
+
+/* Confusable code point to its skeleton (lowercase UTF-8, at most 3 bytes) */
+struct confusable_entry {
+	char32_t from;
+	char     to[4];
+};
+
+/* Sorted by source code point. ASCII, fullwidth and mathematical forms are handled apart. */
+constexpr static const confusable_entry confusables[] = {
+	{ 0x0131, "i"  },   // ı LATIN SMALL LETTER DOTLESS I
+	{ 0x0237, "j"  },   // ȷ LATIN SMALL LETTER DOTLESS J
+	{ 0x0251, "a"  },   // ɑ LATIN SMALL LETTER ALPHA
+	{ 0x0261, "g"  },   // ɡ LATIN SMALL LETTER SCRIPT G
+	{ 0x0269, "i"  },   // ɩ LATIN SMALL LETTER IOTA
+	{ 0x026A, "i"  },   // ɪ LATIN LETTER SMALL CAPITAL I
+	{ 0x028F, "y"  },   // ʏ LATIN LETTER SMALL CAPITAL Y
+	{ 0x0391, "a"  },   // Α GREEK CAPITAL LETTER ALPHA
+	{ 0x0399, "i"  },   // Ι GREEK CAPITAL LETTER IOTA
+	{ 0x039A, "k"  },   // Κ GREEK CAPITAL LETTER KAPPA
+	{ 0x039F, "o"  },   // Ο GREEK CAPITAL LETTER OMICRON
+	{ 0x03A1, "p"  },   // Ρ GREEK CAPITAL LETTER RHO
+	{ 0x03A7, "x"  },   // Χ GREEK CAPITAL LETTER CHI
+	{ 0x03B1, "a"  },   // α GREEK SMALL LETTER ALPHA
+	{ 0x03B3, "y"  },   // γ GREEK SMALL LETTER GAMMA
+	{ 0x03B9, "i"  },   // ι GREEK SMALL LETTER IOTA
+	{ 0x03BD, "v"  },   // ν GREEK SMALL LETTER NU
+	{ 0x03BF, "o"  },   // ο GREEK SMALL LETTER OMICRON
+	{ 0x03C1, "p"  },   // ρ GREEK SMALL LETTER RHO
+	{ 0x03C3, "o"  },   // σ GREEK SMALL LETTER SIGMA
+	{ 0x03C5, "u"  },   // υ GREEK SMALL LETTER UPSILON
+	{ 0x03C7, "x"  },   // χ GREEK SMALL LETTER CHI
+	{ 0x03F2, "c"  },   // ϲ GREEK LUNATE SIGMA SYMBOL
+	{ 0x03F3, "j"  },   // ϳ GREEK LETTER YOT
+	{ 0x0405, "s"  },   // Ѕ CYRILLIC CAPITAL LETTER DZE
+	{ 0x0406, "i"  },   // І CYRILLIC CAPITAL LETTER BYELORUSSIAN-UKRAINIAN I
+	{ 0x0408, "j"  },   // Ј CYRILLIC CAPITAL LETTER JE
+	{ 0x0410, "a"  },   // А CYRILLIC CAPITAL LETTER A
+	{ 0x0415, "e"  },   // Е CYRILLIC CAPITAL LETTER IE
+	{ 0x041E, "o"  },   // О CYRILLIC CAPITAL LETTER O
+	{ 0x0420, "p"  },   // Р CYRILLIC CAPITAL LETTER ER
+	{ 0x0421, "c"  },   // С CYRILLIC CAPITAL LETTER ES
+	{ 0x0425, "x"  },   // Х CYRILLIC CAPITAL LETTER HA
+	{ 0x0430, "a"  },   // а CYRILLIC SMALL LETTER A
+	{ 0x0435, "e"  },   // е CYRILLIC SMALL LETTER IE
+	{ 0x043E, "o"  },   // о CYRILLIC SMALL LETTER O
+	{ 0x0440, "p"  },   // р CYRILLIC SMALL LETTER ER
+	{ 0x0441, "c"  },   // с CYRILLIC SMALL LETTER ES
+	{ 0x0443, "y"  },   // у CYRILLIC SMALL LETTER U
+	{ 0x0445, "x"  },   // х CYRILLIC SMALL LETTER HA
+	{ 0x0455, "s"  },   // ѕ CYRILLIC SMALL LETTER DZE
+	{ 0x0456, "i"  },   // і CYRILLIC SMALL LETTER BYELORUSSIAN-UKRAINIAN I
+	{ 0x0458, "j"  },   // ј CYRILLIC SMALL LETTER JE
+	{ 0x04BB, "h"  },   // һ CYRILLIC SMALL LETTER SHHA
+	{ 0x04C0, "l"  },   // Ӏ CYRILLIC LETTER PALOCHKA
+	{ 0x04CF, "l"  },   // ӏ CYRILLIC SMALL LETTER PALOCHKA
+	{ 0x0501, "cl" },   // ԁ CYRILLIC SMALL LETTER KOMI DE
+	{ 0x051B, "q"  },   // ԛ CYRILLIC SMALL LETTER QA
+	{ 0x051D, "w"  },   // ԝ CYRILLIC SMALL LETTER WE
+	{ 0x0566, "q"  },   // զ ARMENIAN SMALL LETTER ZA
+	{ 0x0570, "h"  },   // հ ARMENIAN SMALL LETTER HO
+	{ 0x0578, "n"  },   // ո ARMENIAN SMALL LETTER VO
+	{ 0x057D, "u"  },   // ս ARMENIAN SMALL LETTER SEH
+	{ 0x0581, "g"  },   // ց ARMENIAN SMALL LETTER CO
+	{ 0x0585, "o"  },   // օ ARMENIAN SMALL LETTER OH
+	{ 0x1D0F, "o"  },   // ᴏ LATIN LETTER SMALL CAPITAL O
+	{ 0x1D1C, "u"  },   // ᴜ LATIN LETTER SMALL CAPITAL U
+	{ 0x1D20, "v"  },   // ᴠ LATIN LETTER SMALL CAPITAL V
+	{ 0x1D21, "w"  },   // ᴡ LATIN LETTER SMALL CAPITAL W
+	{ 0x1D22, "z"  },   // ᴢ LATIN LETTER SMALL CAPITAL Z
+	{ 0x2010, "-"  },   // ‐ HYPHEN
+	{ 0x2011, "-"  },   // ‑ NON-BREAKING HYPHEN
+	{ 0x2012, "-"  },   // ‒ FIGURE DASH
+	{ 0x2013, "-"  },   // – EN DASH
+	{ 0x2212, "-"  },   // − MINUS SIGN
+	{ 0xFE63, "-"  },   // ﹣ SMALL HYPHEN-MINUS
+	{ 0xFF0D, "-"  }    // － FULLWIDTH HYPHEN-MINUS
+};
+
+/* The ASCII characters whose skeleton is not themselves */
+inline const char * ascii_skeleton(char c) {
+
+	switch (c) {
+		case '0': return "o";
+		case '1': return "l";
+		case 'd': return "cl";
+		case 'm': return "rn";
+		default:  return nullptr;
+	}
+}
+
+/**
+ * @brief Finds the script of a code point
+ */
+inline script script_of(char32_t cp) {
+
+	if (cp < 0x80) {
+		if ((cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z'))
+			return LATIN;
+		return COMMON;
+	}
+
+	size_t lo = 0;
+	size_t hi = sizeof(script_ranges) / sizeof(script_range);
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (script_ranges[mid].last < cp)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < (sizeof(script_ranges) / sizeof(script_range)) && script_ranges[lo].first <= cp)
+		return script_ranges[lo].value;
+
+	return OTHER;
+}
+
+/**
+ * @brief Decodes the next UTF-8 code point. Rejects overlongs, surrogates and truncation.
+ *
+ * @return false if the sequence is not well formed.
+ */
+inline bool utf8_next(const unsigned char *in, size_t n, size_t &pos, char32_t &cp) {
+
+	unsigned char b = in[pos];
+
+	if (b < 0x80) {
+		cp = b;
+		++pos;
+		return true;
+	}
+
+	size_t len = 0;
+	char32_t min = 0;
+
+	if (b >= 0xC2 && b <= 0xDF) {
+		len = 2; cp = b & 0x1F; min = 0x80;
+	} else if (b >= 0xE0 && b <= 0xEF) {
+		len = 3; cp = b & 0x0F; min = 0x800;
+	} else if (b >= 0xF0 && b <= 0xF4) {
+		len = 4; cp = b & 0x07; min = 0x10000;
+	} else {
+		return false;
+	}
+
+	if (pos + len > n)
+		return false;
+
+	for (size_t i = 1; i < len; ++i) {
+		unsigned char c = in[pos + i];
+		if ((c & 0xC0) != 0x80)
+			return false;
+		cp = (cp << 6) | (c & 0x3F);
+	}
+
+	if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+		return false;
+
+	pos += len;
+	return true;
+}
+
+/**
+ * @brief Appends the UTF-8 encoding of a code point
+ */
+inline void utf8_append(char32_t cp, std::string &out) {
+
+	if (cp < 0x80) {
+		out.push_back(static_cast<char>(cp));
+	} else if (cp < 0x800) {
+		out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+		out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+	} else if (cp < 0x10000) {
+		out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+		out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+	} else {
+		out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+		out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+		out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+	}
+}
+
+/* Punycode parameters - http://tools.ietf.org/html/rfc3492#section-5 */
+constexpr static uint32_t puny_base         = 36;
+constexpr static uint32_t puny_tmin         = 1;
+constexpr static uint32_t puny_tmax         = 26;
+constexpr static uint32_t puny_skew         = 38;
+constexpr static uint32_t puny_damp         = 700;
+constexpr static uint32_t puny_initial_bias = 72;
+constexpr static uint32_t puny_initial_n    = 128;
+
+inline uint32_t puny_adapt(uint32_t delta, uint32_t numpoints, bool first) {
+
+	delta = first ? (delta / puny_damp) : (delta / 2);
+	delta += delta / numpoints;
+
+	uint32_t k = 0;
+	while (delta > ((puny_base - puny_tmin) * puny_tmax) / 2) {
+		delta /= (puny_base - puny_tmin);
+		k += puny_base;
+	}
+
+	return k + (((puny_base - puny_tmin + 1) * delta) / (delta + puny_skew));
+}
+
+inline uint32_t puny_digit(char c) {
+	if (c >= '0' && c <= '9') return c - '0' + 26;
+	if (c >= 'a' && c <= 'z') return c - 'a';
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	return puny_base;
+}
+
+/**
+ * @brief Decodes a Punycode label (without the "xn--" prefix) into a fixed buffer
+ *
+ * @return false on malformed input or if the result exceeds max_out code points.
+ */
+inline bool punycode_decode(const char *in, size_t n, char32_t *out, size_t &out_n, size_t max_out) {
+
+	constexpr uint32_t max_int = 0xFFFFFFFF;
+
+	size_t b = 0;
+	for (size_t j = 0; j < n; ++j)
+		if (in[j] == '-')
+			b = j;
+
+	out_n = 0;
+
+	for (size_t j = 0; j < b; ++j) {
+		if (static_cast<unsigned char>(in[j]) >= 0x80 || out_n >= max_out)
+			return false;
+		out[out_n++] = static_cast<char32_t>(in[j]);
+	}
+
+	uint32_t i = 0;
+	uint32_t cp = puny_initial_n;
+	uint32_t bias = puny_initial_bias;
+
+	for (size_t pos = (b > 0 ? b + 1 : 0); pos < n; ) {
+
+		uint32_t oldi = i;
+		uint32_t w = 1;
+
+		for (uint32_t k = puny_base; ; k += puny_base) {
+
+			if (pos >= n)
+				return false;
+
+			uint32_t digit = puny_digit(in[pos++]);
+			if (digit >= puny_base)
+				return false;
+
+			if (digit > (max_int - i) / w)
+				return false;
+
+			i += digit * w;
+
+			uint32_t t = (k <= bias) ? puny_tmin :
+				( (k >= bias + puny_tmax) ? puny_tmax : (k - bias) );
+
+			if (digit < t)
+				break;
+
+			if (w > max_int / (puny_base - t))
+				return false;
+
+			w *= (puny_base - t);
+		}
+
+		uint32_t count = static_cast<uint32_t>(out_n + 1);
+		bias = puny_adapt(i - oldi, count, oldi == 0);
+
+		if (i / count > max_int - cp)
+			return false;
+
+		cp += i / count;
+		i %= count;
+
+		if (out_n >= max_out || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+			return false;
+
+		std::memmove(out + i + 1, out + i, (out_n - i) * sizeof(char32_t));
+		out[i++] = cp;
+		++out_n;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Appends the skeleton of a single code point
+ */
+inline void skeleton_append(char32_t cp, std::string &out) {
+
+	/* ASCII is lowercased first */
+	if (cp < 0x80) {
+		char c = static_cast<char>(cp);
+		if (c >= 'A' && c <= 'Z')
+			c += 32;
+
+		const char *s = ascii_skeleton(c);
+		if (s)
+			out.append(s);
+		else
+			out.push_back(c);
+		return;
+	}
+
+	/* FULLWIDTH DIGIT ZERO..FULLWIDTH LATIN SMALL LETTER Z */
+	if (cp >= 0xFF10 && cp <= 0xFF19) {
+		skeleton_append(cp - 0xFF10 + '0', out);
+		return;
+	}
+
+	if (cp >= 0xFF21 && cp <= 0xFF3A) {
+		skeleton_append(cp - 0xFF21 + 'a', out);
+		return;
+	}
+
+	if (cp >= 0xFF41 && cp <= 0xFF5A) {
+		skeleton_append(cp - 0xFF41 + 'a', out);
+		return;
+	}
+
+	/* MATHEMATICAL ALPHANUMERIC SYMBOLS: blocks of A-Z a-z, then blocks of 0-9 */
+	if (cp >= 0x1D400 && cp <= 0x1D6A3) {
+		uint32_t k = (cp - 0x1D400) % 52;
+		skeleton_append( (k < 26 ? ('a' + k) : ('a' + k - 26)), out);
+		return;
+	}
+
+	if (cp >= 0x1D7CE && cp <= 0x1D7FF) {
+		skeleton_append( '0' + ((cp - 0x1D7CE) % 10), out);
+		return;
+	}
+
+	size_t lo = 0;
+	size_t hi = sizeof(confusables) / sizeof(confusable_entry);
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (confusables[mid].from < cp)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < (sizeof(confusables) / sizeof(confusable_entry)) && confusables[lo].from == cp) {
+		out.append(confusables[lo].to);
+		return;
+	}
+
+	utf8_append(cp, out);
+}
+
+/**
+ * @brief Calls fn(cp) for every code point of a label, decoding "xn--" labels first
+ *
+ * @return false if the label is not well formed UTF-8 or Punycode.
+ */
+template <class F>
+inline bool for_each_code_point(const char *label, size_t n, F fn) {
+
+	if (n > 4 &&
+			(label[0] == 'x' || label[0] == 'X') &&
+			(label[1] == 'n' || label[1] == 'N') &&
+			label[2] == '-' && label[3] == '-') {
+
+		char32_t buf[domain::max_label_size];
+		size_t   count = 0;
+
+		if (! punycode_decode(label + 4, n - 4, buf, count, domain::max_label_size))
+			return false;
+
+		for (size_t i = 0; i < count; ++i)
+			fn(buf[i]);
+
+		return true;
+	}
+
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(label);
+
+	for (size_t pos = 0; pos < n; ) {
+		char32_t cp;
+		if (! utf8_next(bytes, n, pos, cp))
+			return false;
+		fn(cp);
+	}
+
+	return true;
+}
+
+/* Script sets allowed together by the highly restrictive profile */
+constexpr static uint32_t script_bit(script s) { return 1u << s; }
+
+constexpr static uint32_t allowed_script_sets[] = {
+	script_bit(LATIN) | script_bit(HAN) | script_bit(HIRAGANA) | script_bit(KATAKANA),  // Japanese
+	script_bit(LATIN) | script_bit(HAN) | script_bit(BOPOMOFO),                         // Chinese
+	script_bit(LATIN) | script_bit(HAN) | script_bit(HANGUL)                            // Korean
+};
+
+} //namespace details
+/// @endcond
+
+/**
+ * @brief Computes the UTS #39 skeleton of a domain name
+ *
+ * Labels in Punycode ("xn--") are decoded first. The skeleton is written into out,
+ * which can be reused between calls to avoid allocations on hot paths.
+ *
+ * @param in  The domain name
+ * @param n   The domain name size in bytes
+ * @param out The resulting skeleton
+ *
+ * @return false if a label is neither well formed UTF-8 nor Punycode.
+ */
+inline bool skeleton(const char *in, size_t n, std::string &out) {
+
+	out.clear();
+
+	/* ASCII fast path: no code point decoding unless a label is Punycode */
+	bool ascii = true;
+	bool ace = false;
+	for (size_t i = 0; i < n && ascii; ++i) {
+		ascii = ( static_cast<unsigned char>(in[i]) < 0x80 );
+		if (in[i] == '-' && i >= 3 && in[i - 1] == '-' && (i == 3 || in[i - 4] == '.'))
+			ace = true;
+	}
+
+	if (ascii && ! ace) {
+		for (size_t i = 0; i < n; ++i)
+			details::skeleton_append(static_cast<unsigned char>(in[i]), out);
+		return true;
+	}
+
+	size_t start = 0;
+
+	for (size_t i = 0; i <= n; ++i) {
+
+		if (i < n && in[i] != '.')
+			continue;
+
+		bool ok = details::for_each_code_point(in + start, i - start, [&out](char32_t cp) {
+				details::skeleton_append(cp, out);
+				});
+
+		if (! ok)
+			return false;
+
+		if (i < n)
+			out.push_back('.');
+
+		start = i + 1;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Computes the UTS #39 skeleton of a domain name
+ *
+ * @return false if a label is neither well formed UTF-8 nor Punycode.
+ */
+inline bool skeleton(const std::string &in, std::string &out) {
+	return skeleton(in.data(), in.size(), out);
+}
+
+/**
+ * @class script_restriction
+ * @brief Checks that every label of a domain name meets the UTS #39 highly restrictive level
+ *
+ * A label must be written in a single script, or only mix Latin with Han and
+ * Hiragana/Katakana, Han and Bopomofo, or Han and Hangul. Common and inherited
+ * characters (digits, hyphen, combining marks) do not count.
+ * Scripts are checked per label, so "пример.com" is accepted while "pаypal.com" is not.
+ *
+ * Does not throw any exception in case of invalid arguments.
+ * Caller must check the script_restriction::has_error().
+ */
+class script_restriction : public error_check {
+
+	public:
+
+		/// The validator type
+		typedef cm::validator<script_restriction, exceptions::mixed_script_domain> validator_type;
+
+		/**
+		 * @brief Checks the scripts of a domain name
+		 *
+		 * @param in The input argument.
+		 */
+		script_restriction(const std::string &in) {
+
+			error_check_assert(in.empty(), "Domain name is empty.");
+
+			size_t start = 0;
+			size_t label = 0;
+
+			for (size_t i = 0; i <= in.size(); ++i) {
+
+				if (i < in.size() && in[i] != '.')
+					continue;
+
+				uint32_t mask = 0;
+
+				bool ok = details::for_each_code_point(in.data() + start, i - start, [&mask](char32_t cp) {
+						script s = details::script_of(cp);
+						if (s != COMMON && s != INHERITED)
+							mask |= details::script_bit(s);
+						});
+
+				error_check_assert(! ok,
+						"Malformed UTF-8 or Punycode in label " + std::to_string(label));
+
+				error_check_assert(! is_allowed(mask),
+						"Mixed scripts in label " + std::to_string(label));
+
+				start = i + 1;
+				++label;
+			}
+		}
+
+	private:
+
+		static bool is_allowed(uint32_t mask) {
+
+			/* Zero or one script */
+			if ((mask & (mask - 1)) == 0)
+				return true;
+
+			for (auto allowed : details::allowed_script_sets)
+				if ((mask & ~allowed) == 0)
+					return true;
+
+			return false;
+		}
+
+};
+
+/**
+ * @class brand_index
+ * @brief Protected domain names indexed by skeleton
+ *
+ * Finds if a host name, or any of its parent domains, is a confusable of a
+ * protected name without being that name. The host skeleton is computed once
+ * and each label suffix costs one hash probe, so a lookup is O(labels).
+ * Protected names with the same skeleton are not confusables of each other.
+ *
+ * The index is immutable after being built; concurrent lookups are safe when
+ * each thread provides its own scratch buffer.
+ */
+class brand_index {
+
+	public:
+
+		/**
+		 * @brief Builds the index from a list of protected domain names
+		 *
+		 * @param brands The protected names (e.g. "paypal.com")
+		 *
+		 * @throw exceptions::invalid_domain if a name is not a valid domain
+		 */
+		brand_index(const std::vector<std::string> &brands) {
+
+			for (const auto &b : brands) {
+
+				std::string name(b, 0, trimmed(b.data(), b.size()));
+
+				domain d(name);
+				if (d.has_error())
+					throw exceptions::invalid_domain(d.error());
+
+				ascii::lower(name);
+				_brands.emplace_back(std::move(name));
+			}
+
+			/* Power of two, at most half full */
+			size_t cap = 16;
+			while (cap < _brands.size() * 2)
+				cap <<= 1;
+
+			_slots.assign(cap, slot());
+
+			std::string sk;
+
+			/* Brands with the same skeleton share a group: none is a confusable of another */
+			for (size_t i = 0; i < _brands.size(); ++i) {
+
+				skeleton(_brands[i], sk);
+
+				uint64_t h = cm::hash::fnv1a64(sk.data(), sk.size());
+				size_t pos = h & (cap - 1);
+
+				for (; _slots[pos].index != npos; pos = (pos + 1) & (cap - 1)) {
+
+					const slot &s = _slots[pos];
+
+					if (s.hash == h && _groups[s.index].skeleton == sk)
+						break;
+				}
+
+				if (_slots[pos].index == npos) {
+					_slots[pos].hash  = h;
+					_slots[pos].index = static_cast<uint32_t>(_groups.size());
+					_groups.push_back(group{ sk, std::vector<uint32_t>() });
+				}
+
+				_groups[_slots[pos].index].brands.push_back(static_cast<uint32_t>(i));
+			}
+		}
+
+		/**
+		 * @brief Finds the protected name imitated by a host name
+		 *
+		 * @param host    The host name to check, with or without its trailing '.' (dot)
+		 * @param scratch A reusable buffer for the skeleton
+		 *
+		 * @return The protected name, or nullptr if the host is not a confusable (or is a protected name).
+		 */
+		const std::string * match(const std::string &host, std::string &scratch) const {
+
+			size_t n = trimmed(host.data(), host.size());
+
+			if (! skeleton(host.data(), n, scratch))
+				return nullptr;
+
+			/* Walk label suffixes of the skeleton and of the host together */
+			size_t sk_pos = 0;
+			size_t host_pos = 0;
+
+			for (;;) {
+
+				const group *g = probe(scratch.data() + sk_pos, scratch.size() - sk_pos);
+
+				if (g && ! is_brand(*g, host.data() + host_pos, n - host_pos))
+					return &_brands[g->brands.front()];
+
+				size_t next_sk = scratch.find('.', sk_pos);
+				const char *next_host = static_cast<const char *>(std::memchr(host.data() + host_pos, '.', n - host_pos));
+
+				if (next_sk == std::string::npos || ! next_host)
+					break;
+
+				sk_pos = next_sk + 1;
+				host_pos = static_cast<size_t>(next_host - host.data()) + 1;
+			}
+
+			return nullptr;
+		}
+
+		/**
+		 * @brief Finds the protected name imitated by a host name
+		 *
+		 * @return The protected name, or nullptr if the host is not a confusable (or is a protected name).
+		 */
+		const std::string * match(const std::string &host) const {
+			std::string scratch;
+			return match(host, scratch);
+		}
+
+		inline size_t size() const { return _brands.size(); }
+
+	private:
+
+		static constexpr uint32_t npos = 0xFFFFFFFF;
+
+		struct slot {
+			uint64_t hash  = 0;
+			uint32_t index = npos;
+		};
+
+		/* The protected names of one skeleton */
+		struct group {
+			std::string           skeleton;
+			std::vector<uint32_t> brands;
+		};
+
+		/* The size without the trailing '.' (dot) of a fully qualified name */
+		static inline size_t trimmed(const char *p, size_t n) {
+			return ( n > 1 && p[n - 1] == '.' ) ? n - 1 : n;
+		}
+
+		bool is_brand(const group &g, const char *p, size_t n) const {
+
+			for (uint32_t i : g.brands)
+				if (ascii::iequals(p, n, _brands[i]))
+					return true;
+
+			return false;
+		}
+
+		const group * probe(const char *p, size_t n) const {
+
+			uint64_t h = cm::hash::fnv1a64(p, n);
+			size_t mask = _slots.size() - 1;
+
+			for (size_t pos = h & mask; _slots[pos].index != npos; pos = (pos + 1) & mask) {
+
+				const slot &s = _slots[pos];
+				const std::string &sk = _groups[s.index].skeleton;
+
+				if (s.hash == h && sk.size() == n && std::memcmp(sk.data(), p, n) == 0)
+					return &_groups[s.index];
+			}
+
+			return nullptr;
+		}
+
+		std::vector<std::string> _brands;
+		std::vector<group>       _groups;
+		std::vector<slot>        _slots;
+
+};
+
+}//namespace dns
+}//namespace cm
+
+#endif //_CM_CONFUSABLE_
@@ -0,0 +1,407 @@
+#ifndef _CM_CUCKOO_
+#define _CM_CUCKOO_
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+
+/*
+
+	Cuckoo filter - https://www.cs.cmu.edu/~dga/papers/cuckoo-conext2014.pdf
+
+	A key is a 16 bit tag stored in one of two buckets of four tags, the second
+	bucket being derived from the first one and the tag only (partial-key cuckoo
+	hashing). A full pair of buckets makes room by moving a tag to its other
+	bucket, and so on. The false positive rate is about 8 / 2^16 and a bucket
+	array holds about 95% of 4 tags per bucket: 2.1 bytes per key.
+
+	Growing - there is no key to rehash, so a full filter gets a new level with
+	twice as many buckets. Lookups check every level; levels double, so there
+	are few of them.
+
+	Concurrency - lookups take no lock. Writers are serialized; moving tags
+	happens under a sequence counter, so a lookup that misses while tags move
+	looks again.
+
+*/
+
+namespace cm {
+
+/**
+ * @class cuckoo_filter
+ * @brief An approximate set of keys, with deletion and concurrent lookups
+ *
+ * Keys are 64 bit hashes, well mixed, e.g. url::fingerprint64(). A key in the
+ * filter is always found; a key not in the filter is found with a probability
+ * of about 1.2e-4 per level.
+ *
+ * cuckoo_filter::contains() may be called from any thread at any time. The
+ * writers (insert, erase) may also be called from any thread, one at a time.
+ *
+ *	cm::cuckoo_filter seen(1 << 20);
+ *	if (seen.insert_unique(cm::url::fingerprint64(u, scratch)))
+ *		frontier.push(u);
+ */
+class cuckoo_filter {
+
+	public:
+
+		/// Maximum number of levels
+		static constexpr size_t max_levels = 32;
+
+		/// Maximum number of tags moved by an insertion
+		static constexpr size_t max_kicks = 500;
+
+		/**
+		 * @brief Creates an empty filter
+		 *
+		 * @param capacity The expected number of keys of the first level
+		 *
+		 * @throw std::invalid_argument if the capacity is zero
+		 */
+		cuckoo_filter(size_t capacity = 1 << 16) {
+
+			if (capacity == 0)
+				throw std::invalid_argument("Invalid cuckoo filter capacity.");
+
+			size_t buckets = 1;
+			while (buckets * 4 * 95 / 100 < capacity)
+				buckets <<= 1;
+
+			for (size_t i = 0; i < max_levels; ++i)
+				_levels[i].store(nullptr, std::memory_order_relaxed);
+
+			add_level(buckets);
+		}
+
+		cuckoo_filter(const cuckoo_filter &) = delete;
+		cuckoo_filter & operator=(const cuckoo_filter &) = delete;
+
+		~cuckoo_filter() {
+			for (size_t i = 0; i < max_levels; ++i)
+				delete _levels[i].load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * @brief Checks if a key is in the filter, without locking
+		 *
+		 * @return true if the key is in the filter, or with a small probability if not.
+		 */
+		bool contains(uint64_t key) const {
+
+			for (;;) {
+
+				uint64_t version = _version.load(std::memory_order_acquire);
+
+				if (find(key))
+					return true;
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+
+				/* No tag moved during the lookup */
+				if (( version & 1 ) == 0 && _version.load(std::memory_order_relaxed) == version)
+					return false;
+			}
+		}
+
+		/**
+		 * @brief Adds a key, even if already there
+		 *
+		 * Adding a key n times needs n erasures to remove it.
+		 *
+		 * @return false if the filter is full, with max_levels levels.
+		 */
+		bool insert(uint64_t key) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			return add(key);
+		}
+
+		/**
+		 * @brief Adds a key if not already there, as one operation
+		 *
+		 * @return true if the key was added, false if it was there or the filter is full.
+		 */
+		bool insert_unique(uint64_t key) {
+
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			if (find(key))
+				return false;
+
+			return add(key);
+		}
+
+		/**
+		 * @brief Removes a key added before
+		 *
+		 * Removing a key never added may remove another key with the same tag.
+		 *
+		 * @return false if the key is not in the filter.
+		 */
+		bool erase(uint64_t key) {
+
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			uint16_t t = tag(key);
+			size_t n = _count.load(std::memory_order_relaxed);
+
+			for (size_t l = n; l-- > 0; ) {
+
+				level *lv = _levels[l].load(std::memory_order_relaxed);
+
+				size_t b1 = key & lv->mask;
+				size_t b2 = alt(b1, t, lv->mask);
+
+				if (remove(lv->buckets[b1], t) || remove(lv->buckets[b2], t)) {
+					_size.fetch_sub(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/// The number of keys
+		inline size_t size() const { return _size.load(std::memory_order_relaxed); }
+
+		/// The number of levels
+		inline size_t levels() const { return _count.load(std::memory_order_acquire); }
+
+		/// The memory used by the buckets, in bytes
+		size_t memory() const {
+
+			size_t ret = 0;
+			size_t n = _count.load(std::memory_order_acquire);
+
+			for (size_t l = 0; l < n; ++l)
+				ret += ( _levels[l].load(std::memory_order_acquire)->mask + 1 ) * sizeof(uint64_t);
+
+			return ret;
+		}
+
+	private:
+
+		/* A bucket is four 16 bit tags in one word, 0 is an empty lane */
+		typedef std::atomic<uint64_t> bucket;
+
+		struct level {
+
+			level(size_t n) : mask(n - 1), buckets(new bucket[n]) {
+				for (size_t i = 0; i < n; ++i)
+					buckets[i].store(0, std::memory_order_relaxed);
+			}
+
+			size_t                    mask;
+			std::unique_ptr<bucket[]> buckets;
+		};
+
+		static constexpr uint64_t lanes_low  = 0x0001000100010001ULL;
+		static constexpr uint64_t lanes_high = 0x8000800080008000ULL;
+
+		static inline uint16_t tag(uint64_t key) {
+			uint16_t t = static_cast<uint16_t>(key >> 48);
+			return t ? t : 1;
+		}
+
+		static inline size_t alt(size_t b, uint16_t t, size_t mask) {
+			return ( b ^ ( t * 0x5bd1e995ULL ) ) & mask;
+		}
+
+		static inline uint16_t lane(uint64_t w, unsigned i) {
+			return static_cast<uint16_t>(w >> ( 16 * i ));
+		}
+
+		/* If any lane is the tag, with the has-zero-byte trick on 16 bit lanes */
+		static inline bool has(uint64_t w, uint16_t t) {
+			uint64_t x = w ^ ( lanes_low * t );
+			return ( ( x - lanes_low ) & ~x & lanes_high ) != 0;
+		}
+
+		static inline bool has_room(uint64_t w) {
+			return has(w, 0);
+		}
+
+		/* Writers only: the lane store is the single change readers see */
+		static bool put(bucket &b, uint16_t t) {
+
+			uint64_t w = b.load(std::memory_order_relaxed);
+
+			for (unsigned i = 0; i < 4; ++i) {
+				if (lane(w, i) == 0) {
+					b.store(w | ( static_cast<uint64_t>(t) << ( 16 * i ) ), std::memory_order_relaxed);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		static bool remove(bucket &b, uint16_t t) {
+
+			uint64_t w = b.load(std::memory_order_relaxed);
+
+			for (unsigned i = 0; i < 4; ++i) {
+				if (lane(w, i) == t) {
+					b.store(w & ~( 0xFFFFULL << ( 16 * i ) ), std::memory_order_relaxed);
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		/* The newest level is the biggest one, it is checked first */
+		bool find(uint64_t key) const {
+
+			uint16_t t = tag(key);
+			size_t n = _count.load(std::memory_order_acquire);
+
+			for (size_t l = n; l-- > 0; ) {
+
+				const level *lv = _levels[l].load(std::memory_order_acquire);
+
+				size_t b1 = key & lv->mask;
+				size_t b2 = alt(b1, t, lv->mask);
+
+				if (has(lv->buckets[b1].load(std::memory_order_relaxed), t) ||
+						has(lv->buckets[b2].load(std::memory_order_relaxed), t))
+					return true;
+			}
+
+			return false;
+		}
+
+		void add_level(size_t buckets) {
+			size_t n = _count.load(std::memory_order_relaxed);
+			_levels[n].store(new level(buckets), std::memory_order_release);
+			_count.store(n + 1, std::memory_order_release);
+		}
+
+		/* Any free lane of any level, then moving tags in the newest level, then a new level */
+		bool add(uint64_t key) {
+
+			uint16_t t = tag(key);
+			size_t n = _count.load(std::memory_order_relaxed);
+
+			for (size_t l = n; l-- > 0; ) {
+
+				level *lv = _levels[l].load(std::memory_order_relaxed);
+
+				size_t b1 = key & lv->mask;
+
+				if (put(lv->buckets[b1], t) || put(lv->buckets[alt(b1, t, lv->mask)], t)) {
+					_size.fetch_add(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+
+			if (! kick(*_levels[n - 1].load(std::memory_order_relaxed), key, t)) {
+
+				if (n == max_levels)
+					return false;
+
+				add_level(( _levels[n - 1].load(std::memory_order_relaxed)->mask + 1 ) * 2);
+
+				level *lv = _levels[n].load(std::memory_order_relaxed);
+				put(lv->buckets[key & lv->mask], t);
+			}
+
+			_size.fetch_add(1, std::memory_order_relaxed);
+
+			return true;
+		}
+
+		/*
+		 * Finds a path of tags to move, ending at a bucket with a free lane, then
+		 * moves them from the end: a tag is copied before it is removed, and the
+		 * version tells the lookups that tags are moving.
+		 */
+		bool kick(level &lv, uint64_t key, uint16_t t) {
+
+			struct step {
+				size_t   bucket;
+				unsigned lane;
+			} path[max_kicks];
+
+			size_t b = key & lv.mask;
+			if (random() & 1)
+				b = alt(b, t, lv.mask);
+
+			for (size_t k = 0; k < max_kicks; ++k) {
+
+				uint64_t w = lv.buckets[b].load(std::memory_order_relaxed);
+
+				/* A lane already in the path would move twice */
+				unsigned first = static_cast<unsigned>(random() & 3);
+				unsigned i = 0;
+
+				for (; i < 4; ++i) {
+
+					unsigned candidate = ( first + i ) & 3;
+					size_t j = 0;
+
+					while (j < k && ( path[j].bucket != b || path[j].lane != candidate ))
+						++j;
+
+					if (j == k)
+						break;
+				}
+
+				if (i == 4)
+					return false;
+
+				path[k].bucket = b;
+				path[k].lane = ( first + i ) & 3;
+
+				size_t next = alt(b, lane(w, path[k].lane), lv.mask);
+
+				if (has_room(lv.buckets[next].load(std::memory_order_relaxed))) {
+
+					uint64_t version = _version.load(std::memory_order_relaxed);
+					_version.store(version + 1, std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_release);
+
+					for (size_t j = k + 1; j-- > 0; ) {
+						bucket &from = lv.buckets[path[j].bucket];
+						uint16_t moved = lane(from.load(std::memory_order_relaxed), path[j].lane);
+						put(lv.buckets[next], moved);
+						from.store(from.load(std::memory_order_relaxed) & ~( 0xFFFFULL << ( 16 * path[j].lane ) ),
+								std::memory_order_relaxed);
+						next = path[j].bucket;
+					}
+
+					put(lv.buckets[next], t);
+
+					_version.store(version + 2, std::memory_order_release);
+
+					return true;
+				}
+
+				b = next;
+			}
+
+			return false;
+		}
+
+		/* xorshift64, writers only */
+		uint64_t random() {
+			_random ^= _random << 13;
+			_random ^= _random >> 7;
+			_random ^= _random << 17;
+			return _random;
+		}
+
+		std::atomic<level *>  _levels[max_levels];
+		std::atomic<size_t>   _count{0};
+		std::atomic<size_t>   _size{0};
+		std::atomic<uint64_t> _version{0};
+		std::mutex            _mutex;
+		uint64_t              _random = 0x9E3779B97F4A7C15ULL;
+
+};
+
+}//namespace cm
+
+#endif //_CM_CUCKOO_
@@ -0,0 +1,537 @@
+#ifndef _CM_SMTP_DECODE_
+#define _CM_SMTP_DECODE_
+
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/smtp.h>
+
+/*
+
+	Quoted-Printable - http://tools.ietf.org/html/rfc2045#section-6.7
+
+	qp-line         := *(qp-segment transport-padding CRLF) qp-part transport-padding
+	qp-segment      := qp-section *(SPACE / TAB) "="  ; soft line break
+	qp-section      := [*(ptext / SPACE / TAB) ptext]
+	ptext           := hex-octet / safe-char
+	hex-octet       := "=" 2(DIGIT / "A" / "B" / "C" / "D" / "E" / "F")
+	safe-char       := <any octet with decimal value of 33 through 126, except "=">
+
+	Trailing white space of a line was added by the transport and is removed.
+
+	Encoded words - http://tools.ietf.org/html/rfc2047#section-2
+
+	encoded-word    = "=?" charset ["*" language] "?" encoding "?" encoded-text "?="
+	encoding        = "B" / "Q"  ; base64 / quoted-printable, "_" for SPACE
+
+	=?utf-8?B?Y2Fmw6k=?=  =?ISO-8859-1?Q?caf=E9?=
+
+	White space between adjacent encoded words is not displayed.
+
+*/
+
+namespace cm {
+namespace smtp {
+
+/**
+ * @class decoder
+ * @brief Strict quoted-printable and RFC 2047 encoded-word decoder
+ *
+ * Decodes into a caller buffer of at least the input size: the decoded form is
+ * never longer. Encoded words are decoded to their raw bytes, the charset is
+ * given to the caller but not converted.
+ *
+ * Stops at the first malformed sequence, whose input offset is kept by
+ * decoder::position(). An instance can be reused, each call resets the error.
+ *
+ *	cm::smtp::decoder d;
+ *	std::string out(body.size(), '\0');
+ *	out.resize(d.quoted_printable(body.data(), body.size(), &out[0]));
+ *	if (d.has_error())
+ *		...
+ *
+ * Does not throw any exception in case of invalid input.
+ * Caller must check the decoder::has_error().
+ */
+class decoder : public error_check {
+
+	public:
+
+		/// Maximum size of an encoded word, RFC 2047
+		static constexpr size_t max_encoded_word_size = 75;
+
+		/**
+		 * @brief Decodes a quoted-printable text
+		 *
+		 * Line breaks may be CRLF or a bare LF, they are kept as they are.
+		 *
+		 * @param in  The encoded text
+		 * @param n   The size
+		 * @param out The output, at least n bytes
+		 *
+		 * @return The number of bytes written, up to the error if any.
+		 */
+		size_t quoted_printable(const char *in, size_t n, char *out) {
+
+			reset();
+
+			size_t w = 0;
+			size_t keep = 0;  // Output size without the trailing literal white space
+
+			for (size_t i = 0; i < n; ) {
+
+				unsigned char c = static_cast<unsigned char>(in[i]);
+
+				switch (qp_class(c)) {
+
+					case Q_SAFE:
+					case Q_WSP: {
+						/* Runs of literal characters are the common case, copied at once */
+						size_t run = i;
+						size_t last = i;
+
+						for (; run < n; ++run) {
+							qp_char k = qp_class(static_cast<unsigned char>(in[run]));
+							if (k == Q_SAFE)
+								last = run + 1;
+							else if (k != Q_WSP)
+								break;
+						}
+
+						std::memcpy(out + w, in + i, run - i);
+						w += run - i;
+
+						if (last > i)
+							keep = w - ( run - last );
+
+						i = run;
+						break;
+					}
+
+					case Q_EQUAL: {
+
+						/* Soft line break, after optional transport padding */
+						size_t j = i + 1;
+						while (j < n && ( in[j] == ' ' || in[j] == '\t' ))
+							++j;
+
+						size_t br = line_break(in, n, j);
+
+						/* The white space before it is data, protected by the "=" */
+						if (br) {
+							i = j + br;
+							keep = w;
+							break;
+						}
+
+						if (i + 2 >= n) {
+							fail(i, "Incomplete quoted-printable escape");
+							return w;
+						}
+
+						int h = hex(in[i + 1]);
+						int l = hex(in[i + 2]);
+
+						if (h < 0 || l < 0) {
+							fail(i, "Invalid quoted-printable escape");
+							return w;
+						}
+
+						out[w++] = static_cast<char>(( h << 4 ) | l);
+						keep = w;
+						i += 3;
+						break;
+					}
+
+					case Q_EOL: {
+
+						size_t br = line_break(in, n, i);
+
+						if (! br) {
+							fail(i, "Bare CR (carriage return) in quoted-printable text");
+							return w;
+						}
+
+						/* Hard line break: drops the transport padding */
+						w = keep;
+
+						for (size_t k = 0; k < br; ++k)
+							out[w++] = in[i++];
+
+						keep = w;
+						break;
+					}
+
+					case Q_BAD:
+						fail(i, "Invalid character in quoted-printable text");
+						return w;
+				}
+			}
+
+			return keep;
+		}
+
+		/**
+		 * @brief Decodes a single encoded word
+		 *
+		 * @param in      The encoded word, from "=?" to "?="
+		 * @param n       The size
+		 * @param out     The output, at least n bytes
+		 * @param charset Receives the charset, without the language, may be nullptr
+		 *
+		 * @return The number of bytes written, 0 on error.
+		 */
+		size_t encoded_word(const char *in, size_t n, char *out, text_view *charset = nullptr) {
+
+			reset();
+
+			size_t end = 0;
+			size_t w = word(in, n, 0, out, charset, end);
+
+			if (has_error())
+				return 0;
+
+			if (end != n) {
+				fail(end, "Unexpected characters after the encoded word");
+				return 0;
+			}
+
+			return w;
+		}
+
+		/**
+		 * @brief Decodes the encoded words of an unstructured header field body
+		 *
+		 * Text outside encoded words is copied as is. White space between
+		 * adjacent encoded words is dropped. A "=?" that starts a word must
+		 * be a well formed encoded word.
+		 *
+		 * @param in  The field body, unfolded or not
+		 * @param n   The size
+		 * @param out The output, at least n bytes
+		 *
+		 * @return The number of bytes written, up to the error if any.
+		 */
+		size_t header(const char *in, size_t n, char *out) {
+
+			reset();
+
+			size_t w = 0;
+			size_t i = 0;
+			bool after_word = false;
+
+			while (i < n) {
+
+				const char *found = static_cast<const char *>(std::memchr(in + i, '=', n - i));
+				size_t next = found ? static_cast<size_t>(found - in) : n;
+
+				/* An encoded word starts a word, "a=?b" is plain text */
+				if (next + 1 < n && in[next + 1] == '?' && ( next == 0 || is_space(in[next - 1]) )) {
+
+					bool blank = true;
+					for (size_t k = i; k < next && blank; ++k)
+						blank = is_space(in[k]);
+
+					if (! ( after_word && blank )) {
+						std::memcpy(out + w, in + i, next - i);
+						w += next - i;
+					}
+
+					size_t end = 0;
+					w += word(in, n, next, out + w, nullptr, end);
+
+					if (has_error())
+						return w;
+
+					if (end < n && ! is_space(in[end])) {
+						fail(end, "Encoded word not separated by white space");
+						return w;
+					}
+
+					i = end;
+					after_word = true;
+					continue;
+				}
+
+				/* Plain text, up to the next candidate */
+				size_t stop = next < n ? next + 1 : n;
+				std::memcpy(out + w, in + i, stop - i);
+				w += stop - i;
+
+				bool blank = true;
+				for (size_t k = i; k < stop && blank; ++k)
+					blank = is_space(in[k]);
+
+				after_word = after_word && blank;
+				i = stop;
+			}
+
+			return w;
+		}
+
+		/// The input offset of the malformed sequence
+		inline size_t position() const { return _position; }
+
+	private:
+
+		enum qp_char {
+			Q_SAFE,   // 33 to 126 but "="
+			Q_WSP,    // SPACE, TAB
+			Q_EQUAL,  // =
+			Q_EOL,    // CR, LF
+			Q_BAD     // other controls and 8 bit
+		};
+
+		static inline qp_char qp_class(unsigned char c) {
+
+			static const struct table {
+
+				unsigned char c[256];
+
+				table() {
+					for (unsigned i = 0; i < 256; ++i)
+						c[i] = ( i >= 33 && i <= 126 ) ? Q_SAFE : Q_BAD;
+
+					c[static_cast<unsigned char>('=')]  = Q_EQUAL;
+					c[static_cast<unsigned char>(' ')]  = Q_WSP;
+					c[static_cast<unsigned char>('\t')] = Q_WSP;
+					c[static_cast<unsigned char>('\r')] = Q_EOL;
+					c[static_cast<unsigned char>('\n')] = Q_EOL;
+				}
+
+			} classes;
+
+			return static_cast<qp_char>(classes.c[c]);
+		}
+
+		/* Base64 values, 64 for the padding and 0xFF for the others */
+		static inline unsigned char b64_value(unsigned char c) {
+
+			static const struct table {
+
+				unsigned char v[256];
+
+				table() {
+					std::memset(v, 0xFF, sizeof(v));
+
+					const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+					for (unsigned i = 0; i < 64; ++i)
+						v[static_cast<unsigned char>(alphabet[i])] = static_cast<unsigned char>(i);
+
+					v[static_cast<unsigned char>('=')] = 64;
+				}
+
+			} values;
+
+			return values.v[c];
+		}
+
+		static inline int hex(char c) {
+			if (c >= '0' && c <= '9') return c - '0';
+			if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+			if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+			return -1;
+		}
+
+		static inline bool is_space(char c) {
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		}
+
+		/* The size of the line break at i: 2 for CRLF, 1 for LF, 0 if none */
+		static inline size_t line_break(const char *in, size_t n, size_t i) {
+			if (i < n && in[i] == '\n')
+				return 1;
+			if (i + 1 < n && in[i] == '\r' && in[i + 1] == '\n')
+				return 2;
+			return 0;
+		}
+
+		/* RFC 2047 token: no SPACE, CTLs nor especials */
+		static inline bool is_token_char(char c) {
+			unsigned char u = static_cast<unsigned char>(c);
+			if (u <= 32 || u >= 127)
+				return false;
+			return std::strchr("()<>@,;:\"/[]?.=", c) == nullptr;
+		}
+
+		void reset() {
+			_err.clear();
+			_position = 0;
+		}
+
+		void fail(size_t pos, const char *err) {
+			std::stringstream ss;
+			ss << err << " [pos: " << pos << "]";
+			set_error(ss.str());
+			_position = pos;
+		}
+
+		/* Decodes the encoded word at pos, end receives the offset after it */
+		size_t word(const char *in, size_t n, size_t pos, char *out, text_view *charset, size_t &end) {
+
+			size_t i = pos;
+
+			if (i + 1 >= n || in[i] != '=' || in[i + 1] != '?') {
+				fail(i, "Missing encoded word '=?' start");
+				return 0;
+			}
+
+			i += 2;
+
+			/* charset ["*" language] */
+			size_t cs = i;
+			while (i < n && is_token_char(in[i]) && in[i] != '*')
+				++i;
+
+			size_t cs_end = i;
+
+			if (i < n && in[i] == '*')
+				while (++i < n && is_token_char(in[i]))
+					;
+
+			if (cs_end == cs || i >= n || in[i] != '?') {
+				fail(i, "Invalid encoded word charset");
+				return 0;
+			}
+
+			if (charset)
+				*charset = text_view(in + cs, cs_end - cs);
+
+			/* encoding */
+			if (i + 2 >= n || in[i + 2] != '?') {
+				fail(i + 1, "Invalid encoded word encoding");
+				return 0;
+			}
+
+			char encoding = in[i + 1];
+			i += 3;
+
+			/* encoded-text */
+			size_t text = i;
+			while (i + 1 < n && ! ( in[i] == '?' && in[i + 1] == '=' )) {
+				if (in[i] == ' ' || in[i] == '\t' || in[i] == '\r' || in[i] == '\n') {
+					fail(i, "White space in encoded word");
+					return 0;
+				}
+				++i;
+			}
+
+			if (i + 1 >= n) {
+				fail(pos, "Unfinished encoded word");
+				return 0;
+			}
+
+			end = i + 2;
+
+			if (end - pos > max_encoded_word_size) {
+				fail(pos, "Encoded word too long");
+				return 0;
+			}
+
+			if (encoding == 'B' || encoding == 'b')
+				return base64(in, text, i, out);
+
+			if (encoding == 'Q' || encoding == 'q')
+				return q(in, text, i, out);
+
+			fail(i - 1, "Invalid encoded word encoding");
+			return 0;
+		}
+
+		/* Strict base64: whole quanta, padding at the end only, zero unused bits */
+		size_t base64(const char *in, size_t from, size_t to, char *out) {
+
+			if (( to - from ) % 4) {
+				fail(from, "Invalid base64 length");
+				return 0;
+			}
+
+			size_t w = 0;
+
+			for (size_t i = from; i < to; i += 4) {
+
+				unsigned char v[4];
+
+				for (size_t k = 0; k < 4; ++k) {
+					v[k] = b64_value(static_cast<unsigned char>(in[i + k]));
+					if (v[k] == 0xFF) {
+						fail(i + k, "Invalid base64 character");
+						return 0;
+					}
+				}
+
+				size_t pad = ( v[3] == 64 ) + ( v[2] == 64 );
+
+				if (v[0] == 64 || v[1] == 64 || ( v[2] == 64 && v[3] != 64 ) || ( pad && i + 4 != to )) {
+					fail(i, "Invalid base64 padding");
+					return 0;
+				}
+
+				uint32_t bits = ( v[0] << 18 ) | ( v[1] << 12 ) | ( ( v[2] & 63 ) << 6 ) | ( v[3] & 63 );
+
+				if (( pad == 1 && ( bits & 0xFF ) ) || ( pad == 2 && ( bits & 0xFFFF ) )) {
+					fail(i, "Invalid base64 trailing bits");
+					return 0;
+				}
+
+				out[w++] = static_cast<char>(bits >> 16);
+				if (pad < 2)
+					out[w++] = static_cast<char>(bits >> 8);
+				if (pad < 1)
+					out[w++] = static_cast<char>(bits);
+			}
+
+			return w;
+		}
+
+		/* Q encoding: "_" is SPACE, "=" is followed by two hex digits */
+		size_t q(const char *in, size_t from, size_t to, char *out) {
+
+			size_t w = 0;
+
+			for (size_t i = from; i < to; ++i) {
+
+				char c = in[i];
+
+				if (c == '_') {
+					out[w++] = ' ';
+					continue;
+				}
+
+				if (c == '=') {
+
+					int h = i + 2 < to ? hex(in[i + 1]) : -1;
+					int l = i + 2 < to ? hex(in[i + 2]) : -1;
+
+					if (h < 0 || l < 0) {
+						fail(i, "Invalid Q encoding escape");
+						return 0;
+					}
+
+					out[w++] = static_cast<char>(( h << 4 ) | l);
+					i += 2;
+					continue;
+				}
+
+				if (qp_class(static_cast<unsigned char>(c)) != Q_SAFE || c == '?') {
+					fail(i, "Invalid character in Q encoded text");
+					return 0;
+				}
+
+				out[w++] = c;
+			}
+
+			return w;
+		}
+
+		size_t _position = 0;
+
+};
+
+}//namespace smtp
+}//namespace cm
+
+#endif //_CM_SMTP_DECODE_
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include <cm/validator.h>
+#include <cm/ascii.h>
 #include <cm/net.h>
 
 namespace cm {
@@ -78,6 +79,95 @@ class domain : public error_check {
 			return ptr(new domain(in));
 		}
 
+		/**
+		 * @brief Checks if a character is allowed in a domain name label
+		 *
+		 *  Letters, digits, hyphens, international characters above U+007F
+		 *  encoded as UTF-8, and spaces, as domain objects always took them.
+		 *  Protocol fields use domain::is_ldh_char() instead.
+		 *
+		 * @param c The input character to evaluate
+		 *
+		 * @return The boolean result.
+		 */
+		static inline bool is_valid_char(char c) {
+
+			// * Uppercase and lowercase English letters (a–z, A–Z) (ASCII: 65–90, 97–122)
+			if ((c >= 65 && c<= 90) || (c>=97 && c<= 122)) return true;
+
+			// * Digits 0 to 9 (ASCII: 48–57)
+			if (c >= 48 && c<= 57) return true;
+
+			// * Hyphens
+			if (c == '-' || c == ' ') return true;
+
+			// * International characters above U+007F, encoded as UTF-8
+			unsigned u = (unsigned ) (c & 0x000000ff);
+			if (u > 0x7f) return true;
+
+			return false;
+		}
+
+		/**
+		 * @brief Checks if a character is allowed in a host name label on the wire
+		 *
+		 *  ASCII letters, digits and hyphens only (RFC 1123 section 2.1): an
+		 *  international name is sent as its A-label ("xn--").
+		 *
+		 * @param c The input character to evaluate
+		 *
+		 * @return The boolean result.
+		 */
+		static inline bool is_ldh_char(char c) {
+			return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) ||
+				( c >= '0' && c <= '9' ) || c == '-';
+		}
+
+		/**
+		 * @brief Checks a single label with the same rules used for the whole name
+		 *
+		 *  Not empty, no longer than max_label_size, only valid characters and
+		 *  no leading or trailing hyphen.
+		 *
+		 * @param p The label first byte
+		 * @param n The label size
+		 *
+		 * @return The boolean result.
+		 */
+		static inline bool is_valid_label(const char *p, size_t n) {
+			return check_label<is_valid_char>(p, n);
+		}
+
+		/**
+		 * @brief Checks a non literal domain name in place, without allocating
+		 *
+		 *  Applies the label rules to every label and refuses all numeric names.
+		 *
+		 * @param p The name first byte
+		 * @param n The name size
+		 *
+		 * @return The boolean result.
+		 */
+		static inline bool is_valid_name(const char *p, size_t n) {
+			return check_name<is_valid_char>(p, n);
+		}
+
+		/**
+		 * @brief Checks a host name as sent in a protocol field, in place
+		 *
+		 *  The rules of domain::is_valid_name() with domain::is_ldh_char()
+		 *  labels, as required for a TLS server name (RFC 6066 section 3)
+		 *  and an SMTP domain (RFC 5321 section 4.1.2).
+		 *
+		 * @param p The name first byte
+		 * @param n The name size
+		 *
+		 * @return The boolean result.
+		 */
+		static inline bool is_ldh_name(const char *p, size_t n) {
+			return check_name<is_ldh_char>(p, n);
+		}
+
 		/**
 		 * @brief Gets the value used to create the domain object.
 		 *
@@ -85,6 +175,24 @@ class domain : public error_check {
 		 */
 		inline const value_type & value() const { return _value; }
 
+		/**
+		 * @brief Gets the canonical domain name: the value in lowercase
+		 *
+		 * Equal names give equal canonical names.
+		 *
+		 * @return The canonical name. Empty if the domain has an error.
+		 */
+		inline value_type canonical() const {
+
+			if (has_error())
+				return value_type();
+
+			value_type ret(_value);
+			ascii::lower(ret);
+
+			return ret;
+		}
+
 
 		/**
 		 * @brief Create a list of domain name labels
@@ -119,50 +227,61 @@ class domain : public error_check {
 		 * @param in The input argument.
 		 */
 		domain(const std::string &in) : _value(in) {
+			check(in.data(), in.size(), *this);
+		}
 
-			if (in.empty()) {
-				_err = "Domain name is empty.";
+		/**
+		 * @brief Checks a domain name in place, without keeping its value
+		 *
+		 * @param in The name first byte
+		 * @param n  The name size
+		 * @param e  Receives the error found, if any
+		 */
+		static void check(const char *in, size_t n, error_check &e) {
+
+			if (n == 0) {
+				e.set_error("Domain name is empty.");
 				return;
 			}
 
-			if (in.size() > max_name_size ) {
-				_err = "Domain name is too big.";
+			if (n > max_name_size ) {
+				e.set_error("Domain name is too big.");
 				return;
 			}
 
 			/* No leading space */
-			if (std::isspace(in.front())) {
-				_err = "Domain name with leading whitespace.";
+			if (std::isspace(in[0])) {
+				e.set_error("Domain name with leading whitespace.");
 				return;
 			}
 
 			/* No trailing space */
-			if (std::isspace(in.back())) {
-				_err = "Domain name with trailing whitespace.";
+			if (std::isspace(in[n - 1])) {
+				e.set_error("Domain name with trailing whitespace.");
 				return;
 			}
 
 			/* Dot (.) at start of local part */
-			if (in.front() == '.') {
-				_err = "Domain name begins with the '.' (Dot) character.";
+			if (in[0] == '.') {
+				e.set_error("Domain name begins with the '.' (Dot) character.");
 				return;
 			}
 
 			/* Dot (.) at end of local part */
-			if (in.back() == '.') {
-				_err = "Domain name ends with the '.' (Dot) character.";
+			if (in[n - 1] == '.') {
+				e.set_error("Domain name ends with the '.' (Dot) character.");
 				return;
 			}
 
 			/* Hyphen (-) at start of local part */
-			if (in.front() == '-') {
-				_err = "Domain name begins with the '-' (Hyphen) character.";
+			if (in[0] == '-') {
+				e.set_error("Domain name begins with the '-' (Hyphen) character.");
 				return;
 			}
 
 			/* Hyphen (-) At end of local part */
-			if (in.back() == '-') {
-				_err = "Domain name ends with the '-' (Hyphen) character.";
+			if (in[n - 1] == '-') {
+				e.set_error("Domain name ends with the '-' (Hyphen) character.");
 				return;
 			}
 
@@ -170,7 +289,7 @@ class domain : public error_check {
 
 			/* Check if value can be IPv4/IPv6 literal */
 			bool is_literal = false;
-			if (in.front() == '[' && in.back() == ']') {
+			if (in[0] == '[' && in[n - 1] == ']') {
 				is_literal = true;
 			}
 
@@ -178,10 +297,10 @@ class domain : public error_check {
 			/* Check address if literal */
 			if (is_literal) {
 
-				net::ip_literal_facade f(in);
+				net::ip_literal_facade f(std::string(in, n));
 
 				if (f.has_error()) {
-					set_error(f);
+					e.set_error(f);
 				}
 
 
@@ -190,35 +309,22 @@ class domain : public error_check {
 				size_t cnt_digits = 0;
 
 				/* Check if all chars are valid */
-				if ( ! std::all_of(in.cbegin(), in.cend(), [&cnt_digits](char c){
-
-							// * Uppercase and lowercase English letters (a–z, A–Z) (ASCII: 65–90, 97–122)
-							if ((c >= 65 && c<= 90) || (c>=97 && c<= 122)) return true;
+				if ( ! std::all_of(in, in + n, [&cnt_digits](char c){
 
 							// * Digits 0 to 9 (ASCII: 48–57)
-							if (c >= 48 && c<= 57) {
-							++cnt_digits;
-							return true;
-							}
-
-							// * Dots and hyphens
-							if (c == '.' || c == '-' || c == ' ') return true;
+							if (c >= 48 && c<= 57) ++cnt_digits;
 
-							//TODO: Not sure about if this is enough
-							// * International characters above U+007F, encoded as UTF-8
-							unsigned u = (unsigned ) (c & 0x000000ff);
-							if (u > 0x7f) return true;
-
-							return false;
+							// * Dots
+							return (c == '.' || is_valid_char(c));
 
 				})) {
 
-					_err = "Domain name has invalid characters.";
+					e.set_error("Domain name has invalid characters.");
 					return;
 				}
 
-				if (cnt_digits == in.size()) {
-					_err = "The domain name is composed only by digit characters." ;
+				if (cnt_digits == n) {
+					e.set_error("The domain name is composed only by digit characters." );
 					return;
 				}
 
@@ -229,20 +335,20 @@ class domain : public error_check {
 			size_t label_len = 0;
 
 			/* Checks if there's any invalid adjacent characters */
-			for (size_t i = 0; i < in.size() ; ++i) {
+			for (size_t i = 0; i < n ; ++i) {
 
 				if (label_len > max_label_size) {
-					_err = "Label size too big for domain at position " + std::to_string(i) ;
+					e.set_error("Label size too big for domain at position " + std::to_string(i) );
 					return;
 				}
 
 				if ( ( in[i] == '-' || in[i] == '.') && previous == '.') {
-					_err = "Invalid sequence of characters for domain at position " + std::to_string(i) ;
+					e.set_error("Invalid sequence of characters for domain at position " + std::to_string(i) );
 					return;
 				}
 
 				if ( in[i] == '.' && previous == '-') {
-					_err = "Invalid sequence of characters for domain at position " + std::to_string(i) ;
+					e.set_error("Invalid sequence of characters for domain at position " + std::to_string(i) );
 					return;
 				}
 
@@ -256,6 +362,49 @@ class domain : public error_check {
 		}
 
 	private:
+
+		template < bool (*C)(char) >
+		static bool check_label(const char *p, size_t n) {
+
+			if (n == 0 || n > max_label_size)
+				return false;
+
+			if (p[0] == '-' || p[n - 1] == '-')
+				return false;
+
+			for (size_t i = 0; i < n; ++i)
+				if (! C(p[i]))
+					return false;
+
+			return true;
+		}
+
+		template < bool (*C)(char) >
+		static bool check_name(const char *p, size_t n) {
+
+			if (n == 0 || n > max_name_size)
+				return false;
+
+			size_t start = 0;
+			bool digits = true;
+
+			for (size_t i = 0; i <= n; ++i) {
+
+				if (i < n && p[i] != '.') {
+					if (p[i] < '0' || p[i] > '9')
+						digits = false;
+					continue;
+				}
+
+				if (! check_label<C>(p + start, i - start))
+					return false;
+
+				start = i + 1;
+			}
+
+			return ! digits;
+		}
+
 		domain() = delete; // Disables the empty constructor
 
 		std::string _value;
@@ -0,0 +1,202 @@
+#ifndef _CM_SMTP_EXTRACT_
+#define _CM_SMTP_EXTRACT_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/domain.h>
+#include <cm/smtp.h>
+
+namespace cm {
+namespace smtp {
+
+/**
+ * @brief Rules applied by the extractor
+ */
+struct extract_options {
+
+	/// Skips addresses whose domain has no dot, as user@localhost
+	bool require_dot = true;
+
+	/// Lets bytes above U+007F be part of an address
+	bool utf8        = false;
+};
+
+/**
+ * @class extractor
+ * @brief Finds email addresses in free text
+ *
+ * Each '@' (at-sign) is found with memchr, then the candidate grows backward
+ * over local part characters and forward over domain characters. Trailing dots
+ * and hyphens are left out, as in "write to john@example.com." A candidate is
+ * reported only if it is a valid smtp::address. Quoted and commented local
+ * parts are not looked for.
+ *
+ * Matches are yielded as offsets into the input, which the caller keeps while
+ * extracting. Nothing is allocated.
+ *
+ *	cm::smtp::extractor x(text);
+ *	cm::smtp::extractor::match m;
+ *	while (x.next(m))
+ *		std::cout << text.substr(m.offset, m.size) << std::endl;
+ */
+class extractor {
+
+	public:
+
+		/// An address found
+		struct match {
+			size_t offset;  ///< The address offset in the input
+			size_t size;    ///< The address size
+			size_t at;      ///< The '@' (at-sign) offset in the address
+		};
+
+		/**
+		 * @brief Prepares the extraction from a text
+		 *
+		 * @param in  The text
+		 * @param n   The size
+		 * @param opt The rules
+		 */
+		extractor(const char *in, size_t n, const extract_options &opt = extract_options())
+			: _p(in), _n(n), _opt(opt) {}
+
+		/// Convenience constructor
+		extractor(const std::string &in, const extract_options &opt = extract_options())
+			: _p(in.data()), _n(in.size()), _opt(opt) {}
+
+		/**
+		 * @brief Finds the next address
+		 *
+		 * @param m The address found
+		 *
+		 * @return false when there are no more addresses.
+		 */
+		bool next(match &m) {
+
+			while (_pos < _n) {
+
+				const char *found = static_cast<const char *>(std::memchr(_p + _pos, '@', _n - _pos));
+
+				if (! found) {
+					_pos = _n;
+					return false;
+				}
+
+				size_t at = static_cast<size_t>(found - _p);
+				_pos = at + 1;
+
+				/* Local part, backward, not over a previous address */
+				size_t start = at;
+				size_t limit = at - _floor > local_part::max_size + 1 ? at - local_part::max_size - 1 : _floor;
+
+				while (start > limit && is_local(_p[start - 1]))
+					--start;
+
+				if (start == limit && limit > _floor && is_local(_p[start - 1]))
+					continue;
+
+				/* Not the tail of a word with non ASCII letters */
+				if (start > _floor && is_utf8(_p[start - 1]))
+					continue;
+
+				while (start < at && _p[start] == '.')
+					++start;
+
+				if (start == at)
+					continue;
+
+				/* Domain, forward */
+				size_t end = at + 1;
+				size_t max = _n - end > dns::domain::max_name_size + 1 ? end + dns::domain::max_name_size + 1 : _n;
+
+				while (end < max && is_domain(_p[end]))
+					++end;
+
+				if (end == max && max < _n && is_domain(_p[end]))
+					continue;
+
+				if (end < _n && is_utf8(_p[end]))
+					continue;
+
+				while (end > at + 1 && ( _p[end - 1] == '.' || _p[end - 1] == '-' ))
+					--end;
+
+				if (end == at + 1)
+					continue;
+
+				if (_opt.require_dot && ! std::memchr(_p + at + 1, '.', end - at - 1))
+					continue;
+
+				/* Confirmation */
+				_check.set_error(std::string());
+				address::check(_p + start, end - start, _check);
+
+				if (_check.has_error())
+					continue;
+
+				m.offset = start;
+				m.size   = end - start;
+				m.at     = at - start;
+
+				_floor = _pos = end;
+
+				return true;
+			}
+
+			return false;
+		}
+
+		/**
+		 * @brief Finds all the remaining addresses
+		 *
+		 * @param out Receives the addresses found
+		 *
+		 * @return The number of addresses found.
+		 */
+		size_t find_all(std::vector<match> &out) {
+			size_t count = 0;
+			match m;
+			while (next(m)) {
+				out.push_back(m);
+				++count;
+			}
+			return count;
+		}
+
+	private:
+
+		inline bool is_local(char c) const {
+			unsigned char u = static_cast<unsigned char>(c);
+			if (u > 0x7f)
+				return _opt.utf8;
+			return c == '.' || local_part::is_atext(u);
+		}
+
+		inline bool is_utf8(char c) const {
+			return ! _opt.utf8 && static_cast<unsigned char>(c) > 0x7f;
+		}
+
+		inline bool is_domain(char c) const {
+			unsigned char u = static_cast<unsigned char>(c);
+			if (u > 0x7f)
+				return _opt.utf8;
+			return c == '.' || ( c != ' ' && dns::domain::is_valid_char(c) );
+		}
+
+		const char *    _p;
+		size_t          _n;
+		extract_options _opt;
+		size_t          _pos = 0;
+		size_t          _floor = 0;
+		error_check     _check;
+
+};
+
+}//namespace smtp
+}//namespace cm
+
+#endif //_CM_SMTP_EXTRACT_
@@ -0,0 +1,191 @@
+#ifndef _CM_HASH_
+#define _CM_HASH_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <cm/ascii.h>
+
+/*
+
+	Hash functions - MurmurHash3 x64 128 (public domain, Austin Appleby)
+	                 FNV-1a 64 - http://www.isthe.com/chongo/tech/comp/fnv/
+
+	Reads are little endian on every platform: a hash can be stored, as the
+	address and URL fingerprints and the typo and blocklist files are.
+
+*/
+
+namespace cm {
+
+/**
+ * @brief A 128 bit fingerprint
+ */
+struct fingerprint128 {
+
+	uint64_t lo = 0;
+	uint64_t hi = 0;
+
+	inline bool operator==(const fingerprint128 &other) const { return lo == other.lo && hi == other.hi; }
+	inline bool operator!=(const fingerprint128 &other) const { return ! operator==(other); }
+};
+
+namespace hash {
+
+/// The FNV-1a 64 offset basis, the hash of no bytes
+constexpr uint64_t fnv1a64_basis = 14695981039346656037ULL;
+
+/// The FNV-1a 64 prime
+constexpr uint64_t fnv1a64_prime = 1099511628211ULL;
+
+/**
+ * @brief Continues an FNV-1a 64 hash with more bytes
+ *
+ * @param h   The hash of the previous bytes
+ * @param key The bytes
+ * @param n   The size
+ *
+ * @return The hash of the previous bytes then these ones.
+ */
+inline uint64_t fnv1a64_append(uint64_t h, const void *key, size_t n) {
+
+	const unsigned char *p = static_cast<const unsigned char *>(key);
+
+	for (size_t i = 0; i < n; ++i) {
+		h ^= p[i];
+		h *= fnv1a64_prime;
+	}
+
+	return h;
+}
+
+/**
+ * @brief FNV-1a 64, fast on short keys such as names
+ *
+ * @param key  The bytes
+ * @param n    The size
+ * @param seed Mixed into the offset basis, 0 for the standard hash
+ *
+ * @return The hash. Its low bits are weak on similar keys, see fmix64().
+ */
+inline uint64_t fnv1a64(const void *key, size_t n, uint64_t seed = 0) {
+	return fnv1a64_append(fnv1a64_basis ^ seed, key, n);
+}
+
+/**
+ * @brief FNV-1a 64 of the text with its ASCII letters lowercased
+ *
+ * Names that are equal ignoring case (RFC 4343) have the same hash.
+ */
+inline uint64_t fnv1a64_lower(const char *p, size_t n, uint64_t seed = 0) {
+
+	uint64_t h = fnv1a64_basis ^ seed;
+
+	for (size_t i = 0; i < n; ++i) {
+		h ^= static_cast<unsigned char>(ascii::lower(p[i]));
+		h *= fnv1a64_prime;
+	}
+
+	return h;
+}
+
+/// Rotates left by 0 to 63 bits
+inline uint64_t rotl64(uint64_t x, int r) {
+	return ( x << r ) | ( x >> ( ( 64 - r ) & 63 ) );
+}
+
+/// The MurmurHash3 finalizer, a 64 bit mixer
+inline uint64_t fmix64(uint64_t k) {
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdULL;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ULL;
+	k ^= k >> 33;
+	return k;
+}
+
+/// Reads 8 bytes as a little endian value, on every platform
+inline uint64_t load64(const unsigned char *p) {
+	uint64_t v = 0;
+	for (int i = 7; i >= 0; --i)
+		v = ( v << 8 ) | p[i];
+	return v;
+}
+
+/**
+ * @brief MurmurHash3_x64_128, the same on every platform
+ *
+ * @param key  The bytes
+ * @param len  The size
+ * @param seed The seed
+ *
+ * @return The 128 bit hash.
+ */
+inline fingerprint128 murmur3_128(const void *key, size_t len, uint64_t seed = 0) {
+
+	const unsigned char *data = static_cast<const unsigned char *>(key);
+	const size_t nblocks = len / 16;
+
+	uint64_t h1 = seed;
+	uint64_t h2 = seed;
+
+	const uint64_t c1 = 0x87c37b91114253d5ULL;
+	const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+	for (size_t i = 0; i < nblocks; ++i) {
+
+		uint64_t k1 = load64(data + i * 16);
+		uint64_t k2 = load64(data + i * 16 + 8);
+
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+
+		h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+
+		h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	const unsigned char *tail = data + nblocks * 16;
+	size_t rest = len & 15;
+
+	uint64_t k1 = 0;
+	uint64_t k2 = 0;
+
+	for (size_t i = rest; i > 8; --i)
+		k2 = ( k2 << 8 ) | tail[i - 1];
+
+	if (rest > 8) {
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+	}
+
+	for (size_t i = ( rest < 8 ? rest : 8 ); i > 0; --i)
+		k1 = ( k1 << 8 ) | tail[i - 1];
+
+	if (rest) {
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+	}
+
+	h1 ^= len;
+	h2 ^= len;
+
+	h1 += h2;
+	h2 += h1;
+
+	h1 = fmix64(h1);
+	h2 = fmix64(h2);
+
+	h1 += h2;
+	h2 += h1;
+
+	fingerprint128 ret;
+	ret.lo = h1;
+	ret.hi = h2;
+
+	return ret;
+}
+
+}//namespace hash
+}//namespace cm
+
+#endif //_CM_HASH_
@@ -0,0 +1,254 @@
+#ifndef _CM_SMTP_HEADER_
+#define _CM_SMTP_HEADER_
+
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/ascii.h>
+#include <cm/smtp.h>
+
+/*
+
+	Header fields - http://tools.ietf.org/html/rfc5322#section-2.2
+
+	field-name      =   1*ftext
+	ftext           =   %d33-57 / %d59-126  ; Printable US-ASCII characters not including ":"
+	field           =   field-name [*WSP] ":" unstructured CRLF  ; [*WSP] is obs-optional
+
+	Folding - http://tools.ietf.org/html/rfc5322#section-2.2.3
+
+	A field body may be split into lines, each continuation line starting with
+	WSP. Unfolding is removing any CRLF that is immediately followed by WSP.
+
+	The header block ends with an empty line, the body follows.
+
+*/
+
+namespace cm {
+namespace smtp {
+
+/**
+ * @class header_block
+ * @brief Splits an RFC 5322 header block into fields
+ *
+ * Fields are yielded one at a time by header_block::next(), as views into the
+ * input, which can be a mapped_file. Lines may end with CRLF or a bare LF.
+ *
+ * Folded values are kept as written; address_list skips the folding whitespace
+ * itself, other validators may use header_block::field::unfold().
+ *
+ *	cm::mapped_file f(path);
+ *	cm::smtp::header_block h(f.data(), f.size());
+ *	cm::smtp::header_block::field fd;
+ *	while (h.next(fd))
+ *		if (fd.is("To"))
+ *			cm::smtp::address_list l(fd.value.data(), fd.value.size());
+ *
+ * Does not throw any exception in case of invalid input.
+ * Caller must check the header_block::has_error() when next() returns false.
+ */
+class header_block : public error_check {
+
+	public:
+
+		/// A header field
+		struct field {
+			text_view name;    ///< The field name
+			text_view value;   ///< The field body, as written: no leading WSP, no final line break
+			size_t    offset;  ///< The field offset in the input
+			bool      folded;  ///< The body has continuation lines
+
+			/**
+			 * @brief Compares the field name, case-insensitive
+			 *
+			 * @param other The name, as a C string
+			 */
+			bool is(const char *other) const {
+
+				size_t n = std::strlen(other);
+
+				if (n != name.size())
+					return false;
+
+				for (size_t i = 0; i < n; ++i)
+					if (ascii::lower(name.data()[i]) != ascii::lower(other[i]))
+						return false;
+
+				return true;
+			}
+
+			/**
+			 * @brief Gets the unfolded field body
+			 *
+			 * A body that is not folded is returned as is, without copies.
+			 *
+			 * @param scratch A reusable buffer for a folded body
+			 *
+			 * @return A view into the input or into the scratch buffer
+			 */
+			text_view unfold(std::string &scratch) const {
+
+				if (! folded)
+					return value;
+
+				const char *p = value.data();
+				size_t n = value.size();
+
+				scratch.clear();
+
+				for (size_t i = 0; i < n; ++i) {
+
+					if (p[i] == '\r' && i + 1 < n && p[i + 1] == '\n')
+						continue;
+
+					if (p[i] == '\n')
+						continue;
+
+					scratch += p[i];
+				}
+
+				return text_view(scratch.data(), scratch.size());
+			}
+		};
+
+		/**
+		 * @brief Prepares the parsing of a header block
+		 *
+		 * @param in The message, kept by the caller while parsing
+		 * @param n  The size
+		 */
+		header_block(const char *in, size_t n) : _p(in), _n(n) {}
+
+		/// Convenience constructor
+		header_block(const std::string &in) : _p(in.data()), _n(in.size()) {}
+
+		/**
+		 * @brief Parses the next field
+		 *
+		 * @param f The field found
+		 *
+		 * @return false at the end of the header block or on an error.
+		 */
+		bool next(field &f) {
+
+			if (_done || has_error())
+				return false;
+
+			if (_pos >= _n) {
+				_done = true;
+				return false;
+			}
+
+			/* Empty line, the body follows */
+			if (_p[_pos] == '\n' || ( _p[_pos] == '\r' && _pos + 1 < _n && _p[_pos + 1] == '\n' )) {
+				_pos += ( _p[_pos] == '\r' ) ? 2 : 1;
+				_done = true;
+				return false;
+			}
+
+			if (is_wsp(_p[_pos]))
+				return fail("Continuation line without a field");
+
+			/* Field name */
+			size_t start = _pos;
+
+			while (_pos < _n && is_ftext(_p[_pos]))
+				++_pos;
+
+			size_t name_end = _pos;
+
+			while (_pos < _n && is_wsp(_p[_pos]))
+				++_pos;
+
+			if (_pos >= _n || _p[_pos] != ':') {
+				if (_pos < _n && _p[_pos] != '\r' && _p[_pos] != '\n')
+					return fail("Invalid character in field name");
+				return fail("Missing field name ':' (colon) separator");
+			}
+
+			if (name_end == start)
+				return fail("Empty field name");
+
+			++_pos;
+
+			while (_pos < _n && is_wsp(_p[_pos]))
+				++_pos;
+
+			/* Field body, up to a line break not followed by WSP */
+			size_t body = _pos;
+			size_t end;
+			bool folded = false;
+
+			for (;;) {
+
+				const char *lf = static_cast<const char *>(std::memchr(_p + _pos, '\n', _n - _pos));
+
+				if (! lf) {
+					/* Last line without a line break */
+					end = _pos = _n;
+					break;
+				}
+
+				size_t eol = static_cast<size_t>(lf - _p);
+
+				_pos = eol + 1;
+
+				if (_pos < _n && is_wsp(_p[_pos])) {
+					folded = true;
+					continue;
+				}
+
+				end = ( eol > body && _p[eol - 1] == '\r' ) ? eol - 1 : eol;
+				break;
+			}
+
+			f.name   = text_view(_p + start, name_end - start);
+			f.value  = text_view(_p + body, end - body);
+			f.offset = start;
+			f.folded = folded;
+
+			return true;
+		}
+
+		/**
+		 * @brief The body offset in the input
+		 *
+		 * Valid once next() has returned false without an error.
+		 * It is the input size if there is no body.
+		 */
+		inline size_t body_offset() const { return _pos; }
+
+		/// Checks if the end of the header block was reached
+		inline bool done() const { return _done; }
+
+	private:
+
+		static inline bool is_wsp(char c) {
+			return c == ' ' || c == '\t';
+		}
+
+		static inline bool is_ftext(char c) {
+			return c >= 33 && c <= 126 && c != ':';
+		}
+
+		bool fail(const char *err) {
+			std::stringstream ss;
+			ss << err << " [pos: " << _pos << "]";
+			set_error(ss.str());
+			return false;
+		}
+
+		const char * _p;
+		size_t       _n;
+		size_t       _pos = 0;
+		bool         _done = false;
+
+};
+
+}//namespace smtp
+}//namespace cm
+
+#endif //_CM_SMTP_HEADER_
@@ -3,6 +3,7 @@
 
 #include <cm/validator.h>
 #include <algorithm>
+#include <numeric>
 #include <initializer_list>
 
 namespace cm {
@@ -0,0 +1,89 @@
+#ifndef _CM_MAPPED_FILE_
+#define _CM_MAPPED_FILE_
+
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cm/validator.h>
+
+namespace cm {
+
+/**
+ * @class mapped_file
+ * @brief A read-only memory mapped file
+ *
+ * The whole file is mapped on construction and unmapped on destruction.
+ *
+ * Does not throw any exception in case of invalid arguments.
+ * Caller must check the mapped_file::has_error().
+ */
+class mapped_file : public error_check {
+
+	public:
+
+		/**
+		 * @brief Maps a file into memory
+		 *
+		 * @param path The file path
+		 */
+		mapped_file(const std::string &path) {
+
+			int fd = ::open(path.c_str(), O_RDONLY);
+			error_check_assert(fd < 0, "Cannot open file " + path);
+
+			struct stat st;
+			if (::fstat(fd, &st) != 0) {
+				::close(fd);
+				set_error("Cannot stat file " + path);
+				return;
+			}
+
+			_size = static_cast<size_t>(st.st_size);
+
+			/* Nothing to map */
+			if (_size == 0) {
+				::close(fd);
+				return;
+			}
+
+			void *p = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+
+			if (p == MAP_FAILED) {
+				_size = 0;
+				set_error("Cannot map file " + path);
+				return;
+			}
+
+			/* Mostly read from start to end */
+			::madvise(p, _size, MADV_SEQUENTIAL);
+
+			_data = static_cast<const char *>(p);
+		}
+
+		~mapped_file() {
+			if (_data)
+				::munmap(const_cast<char *>(_data), _size);
+		}
+
+		inline const char * data() const { return _data; }
+		inline size_t size() const { return _size; }
+
+	private:
+
+		mapped_file() = delete;
+		mapped_file(const mapped_file &) = delete;
+		mapped_file & operator=(const mapped_file &) = delete;
+
+		const char * _data = nullptr;
+		size_t       _size = 0;
+
+};
+
+}//namespace cm
+
+#endif //_CM_MAPPED_FILE_
@@ -0,0 +1,583 @@
+#ifndef _CM_DNS_MESSAGE_
+#define _CM_DNS_MESSAGE_
+
+#include <string>
+#include <stdexcept>
+#include <iterator>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/domain.h>
+#include <cm/wire.h>
+
+/*
+
+	DNS messages - http://tools.ietf.org/html/rfc1035#section-4
+
+	+---------------------+
+	|        Header       |   12 bytes: ID, flags, QDCOUNT, ANCOUNT, NSCOUNT, ARCOUNT
+	+---------------------+
+	|       Question      |   QNAME QTYPE QCLASS
+	+---------------------+
+	|        Answer       |   NAME TYPE CLASS TTL RDLENGTH RDATA
+	+---------------------+
+	|      Authority      |
+	+---------------------+
+	|      Additional     |
+	+---------------------+
+
+	Message compression - http://tools.ietf.org/html/rfc1035#section-4.1.4
+
+	A name may end with a two byte pointer (11 + 14 bit offset) to a prior
+	occurrence of a name suffix in the message. The labels are read forward
+	from the name, or from a pointer target, up to the next pointer; a target
+	inside that run, or after it, would read the same pointer again. So each
+	target must be lower than the start of the run that led to it: targets
+	strictly decrease and a hostile message cannot create a loop. A name
+	follows at most max_pointers of them: a chain of pointers shared by many
+	names would otherwise make validation quadratic on the message size. A
+	real name needs one or two.
+
+*/
+
+namespace cm {
+namespace dns {
+
+namespace exceptions {
+
+/**
+ * @class invalid_message
+ * @brief An exception class to indicate that a DNS message could not be parsed.
+ */
+class invalid_message : public std::invalid_argument {
+	// C++11 inheriting constructors
+	using invalid_argument::invalid_argument;
+};
+
+} //namespace exceptions
+
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+inline uint16_t read_u16(const unsigned char *p) {
+	return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline uint32_t read_u32(const unsigned char *p) {
+	return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+		(static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+/*
+	A label follows the domain rules, except for a leading wildcard label ("*")
+	and leading service labels ("_sip._tcp") as found in real traffic.
+*/
+inline bool is_valid_message_label(const unsigned char *p, size_t n, bool leading) {
+
+	const char *c = reinterpret_cast<const char *>(p);
+
+	if (leading && n == 1 && c[0] == '*')
+		return true;
+
+	if (leading && n > 1 && c[0] == '_') {
+		for (size_t i = 1; i < n; ++i)
+			if (c[i] != '_' && ! domain::is_valid_char(c[i]))
+				return false;
+		return true;
+	}
+
+	return domain::is_valid_label(c, n);
+}
+
+/// Maximum number of compression pointers followed by a name, one per label at most
+constexpr static size_t max_pointers = 127;
+
+/**
+ * @brief Validates a possibly compressed name
+ *
+ * @param msg  The message
+ * @param size The message size
+ * @param pos  The name offset
+ * @param end  The offset after the name at its original location
+ *
+ * @return nullptr if valid, otherwise the error description.
+ */
+inline const char * check_name(const unsigned char *msg, size_t size, size_t pos, size_t &end) {
+
+	size_t wire = 1;         // the root label
+	size_t hops = 0;
+	size_t run = pos;        // where the labels being read start
+	bool jumped = false;
+	bool leading = true;
+
+	for (;;) {
+
+		if (pos >= size)
+			return "Name exceeds the message.";
+
+		unsigned char len = msg[pos];
+
+		/* Compression pointer */
+		if ((len & 0xC0) == 0xC0) {
+
+			if (pos + 1 >= size)
+				return "Truncated compression pointer.";
+
+			size_t target = ((len & 0x3F) << 8) | msg[pos + 1];
+
+			if (! jumped) {
+				end = pos + 2;
+				jumped = true;
+			}
+
+			/* Only before the labels read since the last jump: no loops */
+			if (target >= run)
+				return "Forward or looping compression pointer.";
+
+			if (++hops > max_pointers)
+				return "Too many compression pointers.";
+
+			run = target;
+			pos = target;
+			continue;
+		}
+
+		if (len & 0xC0)
+			return "Unsupported label type.";
+
+		if (len == 0) {
+			if (! jumped)
+				end = pos + 1;
+			return nullptr;
+		}
+
+		if (pos + 1 + len > size)
+			return "Label exceeds the message.";
+
+		wire += len + 1;
+		if (wire > max_wire_size)
+			return "Name too big.";
+
+		if (! is_valid_message_label(msg + pos + 1, len, leading))
+			return "Invalid label.";
+
+		leading = ( leading && ( msg[pos + 1] == '_' || msg[pos + 1] == '*' ) );
+		pos += len + 1;
+	}
+}
+
+} //namespace details
+/// @endcond
+
+/**
+ * @class name_view
+ * @brief A validated, possibly compressed, name inside a DNS message
+ *
+ * Iterates the labels in place, following compression pointers.
+ * The message buffer must outlive the view.
+ */
+class name_view {
+
+	public:
+
+		/// A label inside the message buffer
+		struct label {
+			const unsigned char * data;
+			size_t                size;
+		};
+
+		/// Forward iterator over the labels, excluding the root
+		class label_iterator : public std::iterator<std::forward_iterator_tag, label> {
+
+			public:
+
+				label_iterator() : _msg(nullptr), _pos(npos) { }
+
+				label_iterator(const unsigned char *msg, size_t pos) : _msg(msg), _pos(pos) {
+					skip_pointers();
+				}
+
+				inline label operator*() const {
+					return label{ _msg + _pos + 1, _msg[_pos] };
+				}
+
+				label_iterator & operator++() {
+					_pos += _msg[_pos] + 1;
+					skip_pointers();
+					return *this;
+				}
+
+				label_iterator operator++(int) {
+					label_iterator tmp(*this);
+					++(*this);
+					return tmp;
+				}
+
+				inline bool operator==(const label_iterator &o) const { return _pos == o._pos; }
+				inline bool operator!=(const label_iterator &o) const { return _pos != o._pos; }
+
+			private:
+
+				static constexpr size_t npos = static_cast<size_t>(-1);
+
+				void skip_pointers() {
+
+					while ((_msg[_pos] & 0xC0) == 0xC0)
+						_pos = ((_msg[_pos] & 0x3F) << 8) | _msg[_pos + 1];
+
+					if (_msg[_pos] == 0)
+						_pos = npos;
+				}
+
+				const unsigned char * _msg;
+				size_t                _pos;
+		};
+
+		name_view(const unsigned char *msg, size_t pos) : _msg(msg), _pos(pos) { }
+
+		inline label_iterator begin() const { return label_iterator(_msg, _pos); }
+		inline label_iterator end() const { return label_iterator(); }
+
+		/// Offset of the name in the message
+		inline size_t offset() const { return _pos; }
+
+		/// Checks if this is the root name
+		inline bool is_root() const { return begin() == end(); }
+
+		/**
+		 * @brief Case-insensitive comparison with a name in text, without a trailing dot
+		 */
+		bool iequals(const std::string &text) const {
+
+			size_t i = 0;
+			bool first = true;
+
+			for (auto l : *this) {
+
+				if (! first && ( i >= text.size() || text[i++] != '.' ))
+					return false;
+				first = false;
+
+				if (i + l.size > text.size())
+					return false;
+
+				for (size_t j = 0; j < l.size; ++j)
+					if (details::wire_lower(l.data[j]) !=
+							details::wire_lower(static_cast<unsigned char>(text[i + j])))
+						return false;
+
+				i += l.size;
+			}
+
+			return i == text.size();
+		}
+
+		/**
+		 * @brief Copies the name as text, without a trailing dot
+		 */
+		std::string to_string() const {
+
+			std::string ret;
+
+			for (auto l : *this) {
+				if (! ret.empty())
+					ret.push_back('.');
+				ret.append(reinterpret_cast<const char *>(l.data), l.size);
+			}
+
+			return ret;
+		}
+
+	private:
+
+		const unsigned char * _msg;
+		size_t                _pos;
+};
+
+/**
+ * @brief The fixed size message header
+ */
+struct header {
+
+	uint16_t id;
+	uint16_t flags;
+	uint16_t qdcount;
+	uint16_t ancount;
+	uint16_t nscount;
+	uint16_t arcount;
+
+	inline bool     qr() const     { return ( flags & 0x8000 ) != 0; }
+	inline unsigned opcode() const { return ( flags >> 11 ) & 0x0F; }
+	inline bool     tc() const     { return ( flags & 0x0200 ) != 0; }
+	inline unsigned rcode() const  { return flags & 0x000F; }
+};
+
+/**
+ * @brief A question entry
+ */
+struct question {
+	name_view qname;
+	uint16_t  qtype;
+	uint16_t  qclass;
+};
+
+/// The resource record sections
+enum section {
+	ANSWER = 0,
+	AUTHORITY = 1,
+	ADDITIONAL = 2
+};
+
+/**
+ * @brief A resource record entry. RDATA points into the message.
+ */
+struct resource_record {
+	name_view             name;
+	uint16_t              type;
+	uint16_t              rclass;
+	uint32_t              ttl;
+	const unsigned char * rdata;
+	uint16_t              rdlength;
+};
+
+/**
+ * @class message
+ * @brief Validates a DNS message in place
+ *
+ * Walks the header, questions and resource records of a message held in a
+ * caller buffer. Every owner name and every name in NS, CNAME, PTR, DNAME, MX,
+ * SOA and SRV RDATA is checked with the domain label rules while following
+ * compression pointers; nothing is decompressed or copied.
+ *
+ * Once valid, the sections can be visited with names exposed as label iterators.
+ * The buffer must outlive the message object.
+ *
+ * Does not throw any exception in case of invalid arguments.
+ * Caller must check the message::has_error().
+ */
+class message : public error_check {
+
+	public:
+
+		/// The size of the message header
+		static constexpr size_t header_size = 12;
+
+		/**
+		 * @brief Validates a message
+		 *
+		 * @param data The message bytes
+		 * @param size The message size
+		 */
+		message(const unsigned char *data, size_t size) : _msg(data), _size(size) {
+
+			error_check_assert(size < header_size, "Message too small for the header.");
+
+			_header.id      = details::read_u16(data);
+			_header.flags   = details::read_u16(data + 2);
+			_header.qdcount = details::read_u16(data + 4);
+			_header.ancount = details::read_u16(data + 6);
+			_header.nscount = details::read_u16(data + 8);
+			_header.arcount = details::read_u16(data + 10);
+
+			size_t pos = header_size;
+			const char *err = nullptr;
+
+			for (unsigned i = 0; i < _header.qdcount; ++i) {
+
+				size_t end = 0;
+
+				if ((err = details::check_name(data, size, pos, end))) {
+					fail("Question", i, pos, err);
+					return;
+				}
+
+				if (end + 4 > size) {
+					fail("Question", i, pos, "Truncated question.");
+					return;
+				}
+
+				pos = end + 4;
+			}
+
+			_records = pos;
+
+			unsigned total = _header.ancount + _header.nscount + _header.arcount;
+
+			for (unsigned i = 0; i < total; ++i) {
+
+				size_t end = 0;
+
+				if ((err = details::check_name(data, size, pos, end))) {
+					fail("Record", i, pos, err);
+					return;
+				}
+
+				if (end + 10 > size) {
+					fail("Record", i, pos, "Truncated record.");
+					return;
+				}
+
+				uint16_t type = details::read_u16(data + end);
+				uint16_t rdlength = details::read_u16(data + end + 8);
+				size_t rdata = end + 10;
+
+				if (rdata + rdlength > size) {
+					fail("Record", i, pos, "RDATA exceeds the message.");
+					return;
+				}
+
+				if ((err = check_rdata(type, rdata, rdlength))) {
+					fail("Record", i, rdata, err);
+					return;
+				}
+
+				pos = rdata + rdlength;
+			}
+
+			_end = pos;
+		}
+
+		inline const struct header & get_header() const { return _header; }
+
+		/// The number of bytes used by the message sections
+		inline size_t used() const { return _end; }
+
+		/**
+		 * @brief Visits the questions of a valid message
+		 *
+		 * @param fn Called as fn(const question &)
+		 */
+		template <class F>
+			void for_each_question(F fn) const {
+
+				if (has_error())
+					return;
+
+				size_t pos = header_size;
+
+				for (unsigned i = 0; i < _header.qdcount; ++i) {
+
+					size_t end = skip_name(pos);
+
+					fn(question{ name_view(_msg, pos),
+							details::read_u16(_msg + end),
+							details::read_u16(_msg + end + 2) });
+
+					pos = end + 4;
+				}
+			}
+
+		/**
+		 * @brief Visits the resource records of a valid message
+		 *
+		 * @param fn Called as fn(section, const resource_record &)
+		 */
+		template <class F>
+			void for_each_record(F fn) const {
+
+				if (has_error())
+					return;
+
+				size_t pos = _records;
+				unsigned counts[] = { _header.ancount, _header.nscount, _header.arcount };
+
+				for (unsigned s = ANSWER; s <= ADDITIONAL; ++s) {
+					for (unsigned i = 0; i < counts[s]; ++i) {
+
+						size_t end = skip_name(pos);
+
+						resource_record rr{ name_view(_msg, pos),
+							details::read_u16(_msg + end),
+							details::read_u16(_msg + end + 2),
+							details::read_u32(_msg + end + 4),
+							_msg + end + 10,
+							details::read_u16(_msg + end + 8) };
+
+						fn(static_cast<section>(s), rr);
+
+						pos = end + 10 + rr.rdlength;
+					}
+				}
+			}
+
+	private:
+
+		message() = delete;
+
+		void fail(const char *what, unsigned index, size_t pos, const char *err) {
+			set_error(std::string(what) + " " + std::to_string(index) + " at offset " +
+					std::to_string(pos) + ": " + err);
+		}
+
+		/* The name end in a validated message */
+		size_t skip_name(size_t pos) const {
+
+			while (_msg[pos] != 0) {
+				if ((_msg[pos] & 0xC0) == 0xC0)
+					return pos + 2;
+				pos += _msg[pos] + 1;
+			}
+
+			return pos + 1;
+		}
+
+		/* Checks an RDATA made of a fixed prefix and names, ending at the RDATA end */
+		const char * check_names(size_t pos, size_t rdend, size_t prefix, unsigned names, size_t suffix) const {
+
+			pos += prefix;
+
+			for (unsigned i = 0; i < names; ++i) {
+
+				size_t end = 0;
+
+				if (pos >= rdend)
+					return "Truncated RDATA.";
+
+				/* Names may not extend past the RDATA */
+				const char *err = details::check_name(_msg, rdend, pos, end);
+				if (err)
+					return err;
+
+				pos = end;
+			}
+
+			return ( pos + suffix == rdend ) ? nullptr : "Invalid RDATA length.";
+		}
+
+		const char * check_rdata(uint16_t type, size_t pos, uint16_t len) const {
+
+			size_t rdend = pos + len;
+
+			switch (type) {
+				case 2:  // NS
+				case 5:  // CNAME
+				case 12: // PTR
+				case 39: // DNAME
+					return check_names(pos, rdend, 0, 1, 0);
+				case 15: // MX
+					return check_names(pos, rdend, 2, 1, 0);
+				case 33: // SRV
+					return check_names(pos, rdend, 6, 1, 0);
+				case 6:  // SOA
+					return check_names(pos, rdend, 0, 2, 20);
+				case 1:  // A
+					return ( len == 4 ) ? nullptr : "Invalid A RDATA length.";
+				case 28: // AAAA
+					return ( len == 16 ) ? nullptr : "Invalid AAAA RDATA length.";
+				default:
+					return nullptr;
+			}
+		}
+
+		const unsigned char * _msg;
+		size_t                _size;
+		size_t                _records = 0;
+		size_t                _end = 0;
+		struct header         _header = header();
+
+};
+
+}//namespace dns
+}//namespace cm
+
+#endif //_CM_DNS_MESSAGE_
@@ -1,4 +1,4 @@
-#ifndef _CM_NET__
+#ifndef _CM_NET_
 #define _CM_NET_
 
 #include <string>
@@ -7,6 +7,7 @@
 #include <algorithm>
 
 #include <type_traits>
+#include <cstring>
 
 #include <arpa/inet.h>
 #include <cm/validator.h>
@@ -36,6 +37,20 @@ inline bool is_ip(int af, const std::string &addr, unsigned char *buf ) {
 	return false;
 
 }
+
+/* The same, in place: the text is copied to the stack, an address is short */
+inline bool is_ip(int af, const char *addr, size_t n, unsigned char *buf) {
+
+	char text[INET6_ADDRSTRLEN];
+
+	if (n >= sizeof(text) || std::memchr(addr, '\0', n))
+		return false;
+
+	std::memcpy(text, addr, n);
+	text[n] = '\0';
+
+	return inet_pton(af, text, (void *) buf) > 0;
+}
 } // namespace detail
 /// @endcond
 
@@ -182,6 +197,12 @@ class ip_base : public error_check {
 		inline bool is_ipv4() const { return _af == AF_INET; }
 		inline int  family()  const { return _af; }
 
+		/// The address in network byte order
+		inline const unsigned char * data() const { return _buf; }
+
+		/// The address size in bytes: 4 or 16
+		inline size_t size() const { return _af == AF_INET ? 4 : 16; }
+
 		/**
 		 * @brief
 		 *
@@ -228,6 +249,21 @@ class ipv6 : public ip_base {
 			}
 		}
 
+		/**
+		 * @brief Checks an IPv6 address in place, without allocating
+		 *
+		 * @param in The address first byte
+		 * @param n  The address size
+		 * @param e  Receives the error found, if any
+		 */
+		static void check(const char *in, size_t n, error_check &e) {
+
+			unsigned char buf[sizeof(struct in6_addr)];
+
+			if (! detail::is_ip(AF_INET6, in, n, buf))
+				e.set_error("Invalid IPv6 address.");
+		}
+
 };
 
 
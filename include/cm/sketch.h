@@ -0,0 +1,512 @@
+#ifndef _CM_SKETCH_
+#define _CM_SKETCH_
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/hash.h>
+#include <cm/domain.h>
+#include <cm/net.h>
+#include <cm/smtp.h>
+
+/*
+
+	Count-Min sketch - http://dimacs.rutgers.edu/~graham/pubs/papers/cm-full.pdf
+
+	depth rows of width counters. A key adds its count to one counter per row
+	and its estimate is the smallest of those counters. The estimate is never
+	below the true count and exceeds it by at most e / width * total with
+	probability 1 - exp(-depth).
+
+	Space-Saving - http://www.cs.ucsb.edu/research/tech-reports/2005-23
+
+	Monitors at most capacity keys. An unmonitored key replaces the key with
+	the smallest count and inherits that count as its error. Any key with a
+	count above total / capacity is monitored.
+
+	Both are mergeable - http://arxiv.org/abs/1202.5744
+
+*/
+
+namespace cm {
+
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+/* FNV-1a with a final mix, the low and high halves are used as two hashes */
+inline uint64_t sketch_hash(const void *key, size_t n, uint64_t seed = 0) {
+	return hash::fmix64(hash::fnv1a64(key, n, seed));
+}
+
+} //namespace details
+/// @endcond
+
+/**
+ * @brief The sketch key of a domain: its canonical name
+ */
+inline std::string sketch_key(const dns::domain &d) {
+	return d.canonical();
+}
+
+/**
+ * @brief The sketch key of an IP address: its bytes in network order
+ */
+inline std::string sketch_key(const net::ip_base &ip) {
+	return std::string(reinterpret_cast<const char *>(ip.data()), ip.size());
+}
+
+/**
+ * @brief The sketch key of an email address: its canonical domain name
+ */
+inline std::string sketch_key(const smtp::address &a) {
+	return a.get_domain().canonical();
+}
+
+/**
+ * @class count_min
+ * @brief Estimates the count of any key in a fixed memory
+ *
+ * Sketches with the same width, depth and seed can be merged, e.g. one per thread.
+ */
+class count_min {
+
+	public:
+
+		/**
+		 * @brief Creates an empty sketch
+		 *
+		 * @param width The counters per row, rounded up to a power of two
+		 * @param depth The number of rows
+		 * @param seed  The hash seed
+		 *
+		 * @throw std::invalid_argument if the width or the depth is zero
+		 */
+		count_min(size_t width = 2048, size_t depth = 4, uint64_t seed = 0) : _depth(depth), _seed(seed) {
+
+			if (width == 0 || depth == 0)
+				throw std::invalid_argument("Invalid count-min sketch size.");
+
+			_width = 1;
+			while (_width < width)
+				_width <<= 1;
+
+			_cells.assign(_width * _depth, 0);
+		}
+
+		/**
+		 * @brief Adds a count to a key
+		 */
+		void add(const void *key, size_t n, uint64_t count = 1) {
+
+			uint64_t h = details::sketch_hash(key, n, _seed);
+			uint64_t h1 = h & 0xFFFFFFFF;
+			uint64_t h2 = ( h >> 32 ) | 1;
+
+			for (size_t row = 0; row < _depth; ++row)
+				_cells[row * _width + ( ( h1 + row * h2 ) & ( _width - 1 ) )] += count;
+
+			_total += count;
+		}
+
+		/// Convenience overload
+		inline void add(const std::string &key, uint64_t count = 1) {
+			add(key.data(), key.size(), count);
+		}
+
+		/**
+		 * @brief Estimates the count of a key
+		 *
+		 * @return The estimate. It is never below the true count.
+		 */
+		uint64_t estimate(const void *key, size_t n) const {
+
+			uint64_t h = details::sketch_hash(key, n, _seed);
+			uint64_t h1 = h & 0xFFFFFFFF;
+			uint64_t h2 = ( h >> 32 ) | 1;
+
+			uint64_t ret = UINT64_MAX;
+
+			for (size_t row = 0; row < _depth; ++row)
+				ret = std::min(ret, _cells[row * _width + ( ( h1 + row * h2 ) & ( _width - 1 ) )]);
+
+			return ret;
+		}
+
+		/// Convenience overload
+		inline uint64_t estimate(const std::string &key) const {
+			return estimate(key.data(), key.size());
+		}
+
+		/**
+		 * @brief Adds the counts of another sketch
+		 *
+		 * @throw std::invalid_argument if the sketches have a different width, depth or seed
+		 */
+		void merge(const count_min &other) {
+
+			if (other._width != _width || other._depth != _depth || other._seed != _seed)
+				throw std::invalid_argument("Count-min sketches do not match.");
+
+			for (size_t i = 0; i < _cells.size(); ++i)
+				_cells[i] += other._cells[i];
+
+			_total += other._total;
+		}
+
+		/// The sum of all counts added
+		inline uint64_t total() const { return _total; }
+
+		inline size_t width() const { return _width; }
+		inline size_t depth() const { return _depth; }
+
+	private:
+
+		size_t                _width;
+		size_t                _depth;
+		uint64_t              _seed;
+		uint64_t              _total = 0;
+		std::vector<uint64_t> _cells;
+
+};
+
+/**
+ * @class space_saving
+ * @brief Tracks the top keys of a stream in a fixed memory
+ *
+ * Updates cost one hash probe and a heap update, O(log capacity). Only the
+ * keys monitored are stored.
+ *
+ * Summaries can be merged, e.g. one per thread.
+ */
+class space_saving {
+
+	public:
+
+		/// A monitored key
+		struct item {
+			std::string key;    ///< The key
+			uint64_t    count;  ///< The estimated count, never below the true count
+			uint64_t    error;  ///< The maximum overestimation of the count
+		};
+
+		/**
+		 * @brief Creates an empty summary
+		 *
+		 * @param capacity The maximum number of keys monitored
+		 *
+		 * @throw std::invalid_argument if the capacity is zero
+		 */
+		explicit space_saving(size_t capacity = 100) : _capacity(capacity) {
+
+			if (capacity == 0 || capacity >= npos)
+				throw std::invalid_argument("Invalid space-saving capacity.");
+
+			size_t cap = 16;
+			while (cap < capacity * 2)
+				cap <<= 1;
+
+			_slots.assign(cap, static_cast<uint32_t>(npos));
+			_items.reserve(capacity);
+		}
+
+		/**
+		 * @brief Adds a count to a key
+		 */
+		void add(const void *key, size_t n, uint64_t count = 1) {
+
+			uint64_t h = details::sketch_hash(key, n);
+			uint32_t i = find(h, key, n);
+
+			_total += count;
+
+			if (i != npos) {
+				_items[i].count += count;
+				sift_down(_pos[i]);
+				return;
+			}
+
+			if (_items.size() < _capacity) {
+
+				i = static_cast<uint32_t>(_items.size());
+
+				_items.push_back(item{ std::string(static_cast<const char *>(key), n), count, 0 });
+				_hashes.push_back(h);
+				_pos.push_back(static_cast<uint32_t>(_heap.size()));
+				_heap.push_back(i);
+
+				insert(i);
+				sift_up(_pos[i]);
+				return;
+			}
+
+			/* Replaces the key with the smallest count */
+			i = _heap[0];
+			erase(i);
+
+			item &victim = _items[i];
+			victim.key.assign(static_cast<const char *>(key), n);
+			victim.error = victim.count;
+			victim.count += count;
+			_hashes[i] = h;
+
+			insert(i);
+			sift_down(0);
+		}
+
+		/// Convenience overload
+		inline void add(const std::string &key, uint64_t count = 1) {
+			add(key.data(), key.size(), count);
+		}
+
+		/**
+		 * @brief Estimates the count of a key
+		 *
+		 * @return The estimate. It is never below the true count.
+		 */
+		uint64_t estimate(const std::string &key) const {
+
+			uint32_t i = find(details::sketch_hash(key.data(), key.size()), key.data(), key.size());
+
+			if (i != npos)
+				return _items[i].count;
+
+			return min_count();
+		}
+
+		/**
+		 * @brief Gets the top keys
+		 *
+		 * @param n The maximum number of keys
+		 *
+		 * @return The keys, by decreasing count.
+		 */
+		std::vector<item> top(size_t n) const {
+
+			std::vector<item> ret(_items);
+			n = std::min(n, ret.size());
+
+			std::partial_sort(ret.begin(), ret.begin() + n, ret.end(), [](const item &a, const item &b) {
+				return a.count > b.count;
+			});
+
+			ret.resize(n);
+
+			return ret;
+		}
+
+		/**
+		 * @brief Adds the counts of another summary
+		 *
+		 * An unmonitored key may have had up to the smallest count of a full
+		 * summary, so that count is added to its estimate and error.
+		 */
+		void merge(const space_saving &other) {
+
+			uint64_t mine = min_count();
+			uint64_t theirs = other.min_count();
+
+			std::vector<item> merged;
+			merged.reserve(_items.size() + other._items.size());
+
+			for (size_t i = 0; i < _items.size(); ++i) {
+
+				const item &a = _items[i];
+				uint32_t j = other.find(_hashes[i], a.key.data(), a.key.size());
+
+				if (j != npos)
+					merged.push_back(item{ a.key, a.count + other._items[j].count, a.error + other._items[j].error });
+				else
+					merged.push_back(item{ a.key, a.count + theirs, a.error + theirs });
+			}
+
+			for (size_t j = 0; j < other._items.size(); ++j) {
+
+				const item &b = other._items[j];
+
+				if (find(other._hashes[j], b.key.data(), b.key.size()) == npos)
+					merged.push_back(item{ b.key, b.count + mine, b.error + mine });
+			}
+
+			if (merged.size() > _capacity) {
+				std::nth_element(merged.begin(), merged.begin() + _capacity, merged.end(), [](const item &a, const item &b) {
+					return a.count > b.count;
+				});
+				merged.resize(_capacity);
+			}
+
+			uint64_t total = _total + other._total;
+
+			clear();
+
+			for (auto &m : merged) {
+				add(m.key, m.count);
+				_items.back().error = m.error;
+			}
+
+			_total = total;
+		}
+
+		/**
+		 * @brief Removes all keys
+		 */
+		void clear() {
+			_items.clear();
+			_hashes.clear();
+			_heap.clear();
+			_pos.clear();
+			_slots.assign(_slots.size(), static_cast<uint32_t>(npos));
+			_total = 0;
+		}
+
+		/// The number of keys monitored
+		inline size_t size() const { return _items.size(); }
+
+		/// The maximum number of keys monitored
+		inline size_t capacity() const { return _capacity; }
+
+		/// The sum of all counts added
+		inline uint64_t total() const { return _total; }
+
+	private:
+
+		static constexpr uint32_t npos = 0xFFFFFFFF;
+
+		/* The count an unmonitored key may have had */
+		uint64_t min_count() const {
+			return _items.size() < _capacity ? 0 : _items[_heap[0]].count;
+		}
+
+		inline size_t mask() const { return _slots.size() - 1; }
+
+		uint32_t find(uint64_t h, const void *key, size_t n) const {
+
+			for (size_t pos = h & mask(); _slots[pos] != npos; pos = (pos + 1) & mask()) {
+
+				uint32_t i = _slots[pos];
+
+				if (_hashes[i] == h && _items[i].key.size() == n && std::memcmp(_items[i].key.data(), key, n) == 0)
+					return i;
+			}
+
+			return npos;
+		}
+
+		void insert(uint32_t i) {
+
+			size_t pos = _hashes[i] & mask();
+
+			while (_slots[pos] != npos)
+				pos = (pos + 1) & mask();
+
+			_slots[pos] = i;
+		}
+
+		/* Linear probing removal, shifts back the following entries */
+		void erase(uint32_t i) {
+
+			size_t hole = _hashes[i] & mask();
+			while (_slots[hole] != i)
+				hole = (hole + 1) & mask();
+
+			for (size_t pos = ( hole + 1 ) & mask(); _slots[pos] != npos; pos = (pos + 1) & mask()) {
+
+				size_t home = _hashes[_slots[pos]] & mask();
+
+				/* Moves it if its home is not between the hole and its position */
+				if (( ( pos - home ) & mask() ) >= ( ( pos - hole ) & mask() )) {
+					_slots[hole] = _slots[pos];
+					hole = pos;
+				}
+			}
+
+			_slots[hole] = static_cast<uint32_t>(npos);
+		}
+
+		/* Min-heap of item indexes by count */
+		inline bool less(size_t a, size_t b) const {
+			return _items[_heap[a]].count < _items[_heap[b]].count;
+		}
+
+		inline void swap(size_t a, size_t b) {
+			std::swap(_heap[a], _heap[b]);
+			_pos[_heap[a]] = static_cast<uint32_t>(a);
+			_pos[_heap[b]] = static_cast<uint32_t>(b);
+		}
+
+		void sift_up(size_t k) {
+			while (k && less(k, ( k - 1 ) / 2)) {
+				swap(k, ( k - 1 ) / 2);
+				k = ( k - 1 ) / 2;
+			}
+		}
+
+		void sift_down(size_t k) {
+
+			for (;;) {
+
+				size_t child = 2 * k + 1;
+
+				if (child >= _heap.size())
+					return;
+
+				if (child + 1 < _heap.size() && less(child + 1, child))
+					++child;
+
+				if (! less(child, k))
+					return;
+
+				swap(k, child);
+				k = child;
+			}
+		}
+
+		size_t                _capacity;
+		uint64_t              _total = 0;
+
+		std::vector<item>     _items;
+		std::vector<uint64_t> _hashes;
+		std::vector<uint32_t> _heap;
+		std::vector<uint32_t> _pos;
+		std::vector<uint32_t> _slots;
+
+};
+
+/**
+ * @class tracking
+ * @brief A cm::validator policy feeding every good object to a sketch
+ *
+ * The object is keyed with cm::sketch_key(). The validator is then not safe
+ * to share between threads: use one per thread and merge their sketches.
+ *
+ *	cm::validator<cm::dns::domain, cm::dns::exceptions::invalid_domain, false, cm::tracking<>> v;
+ *	v.sketch().top(10);
+ */
+template <class S = space_saving>
+class tracking {
+
+	public:
+
+		inline S & sketch() { return _sketch; }
+		inline const S & sketch() const { return _sketch; }
+
+	protected:
+
+		template <class V>
+		void track(const V &v) {
+			_sketch.add(sketch_key(v));
+		}
+
+	private:
+
+		S _sketch;
+
+};
+
+}//namespace cm
+
+#endif //_CM_SKETCH_
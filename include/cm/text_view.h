@@ -0,0 +1,42 @@
+#ifndef _CM_TEXT_VIEW_
+#define _CM_TEXT_VIEW_
+
+#include <string>
+#include <algorithm>
+#include <cstddef>
+
+namespace cm {
+
+/**
+ * @class text_view
+ * @brief A view of some text, valid while the text lives
+ */
+class text_view {
+
+	public:
+
+		text_view() : _p(nullptr), _n(0) {}
+		text_view(const char *p, size_t n) : _p(p), _n(n) {}
+
+		inline const char * data() const { return _p; }
+		inline size_t size() const { return _n; }
+		inline bool empty() const { return _n == 0; }
+
+		/// A copy of the text
+		inline std::string value() const { return std::string(_p, _n); }
+
+		inline bool operator==(const std::string &other) const {
+			return other.size() == _n && std::equal(_p, _p + _n, other.begin());
+		}
+
+		inline bool operator!=(const std::string &other) const { return ! operator==(other); }
+
+	protected:
+
+		const char * _p;
+		size_t       _n;
+};
+
+}//namespace cm
+
+#endif //_CM_TEXT_VIEW_
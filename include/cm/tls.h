@@ -0,0 +1,610 @@
+#ifndef _CM_TLS_
+#define _CM_TLS_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#include <cm/ascii.h>
+#include <cm/hash.h>
+#include <cm/domain.h>
+
+/*
+
+	TLS record layer - http://tools.ietf.org/html/rfc5246#section-6.2.1
+
+	struct {
+		ContentType type;                 // 22 handshake
+		ProtocolVersion version;          // 3.x
+		uint16 length;                    // <= 2^14
+		opaque fragment[TLSPlaintext.length];
+	} TLSPlaintext;
+
+	Client hello - http://tools.ietf.org/html/rfc5246#section-7.4.1.2
+
+	HandshakeType msg_type (1) | uint24 length
+	ProtocolVersion client_version;
+	Random random;                                  // 32 bytes
+	SessionID session_id<0..32>;
+	CipherSuite cipher_suites<2..2^16-2>;
+	CompressionMethod compression_methods<1..2^8-1>;
+	Extension extensions<0..2^16-1>;                // type (2) | opaque data<0..2^16-1>
+
+	Server name indication - http://tools.ietf.org/html/rfc6066#section-3
+
+	struct {
+		NameType name_type;                         // 0 host_name
+		HostName host_name<1..2^16-1>;
+	} ServerName;
+	ServerName server_name_list<1..2^16-1>;         // extension type 0
+
+	Wildcard certificates - http://tools.ietf.org/html/rfc6125#section-6.4.3
+
+	*.example.com matches www.example.com
+	*.example.com does not match example.com nor a.b.example.com
+	*.com and w*.example.com are not used
+
+*/
+
+namespace cm {
+
+/**
+ * @namespace cm::tls
+ * @brief Classes for the TLS protocol
+ */
+namespace tls {
+
+/**
+ * @class sni_parser
+ * @brief Extracts the server name from a TLS ClientHello as bytes arrive
+ *
+ * Bytes are fed as they are read from the connection, in any split, and each
+ * byte is looked at once. The ClientHello may span several records. Only the
+ * host name is copied, into a fixed buffer; nothing is allocated.
+ *
+ * Hostile input is bounded: lengths are checked against their enclosing
+ * structure and the ClientHello size is capped at max_hello_size.
+ *
+ * The host name is checked with the domain name rules. IP literals are refused,
+ * as required by RFC 6066.
+ */
+class sni_parser {
+
+	public:
+
+		/// The parser status
+		enum status {
+			NEED_MORE = 0,  ///< Feed more bytes
+			FOUND     = 1,  ///< A valid server name was found
+			NO_SNI    = 2,  ///< A complete ClientHello without the server name extension
+			FAILED    = 3   ///< Not a ClientHello, malformed or an invalid server name
+		};
+
+		/// The maximum ClientHello handshake message size accepted
+		static constexpr size_t max_hello_size = 1 << 16;
+
+		sni_parser() { reset(); }
+
+		/**
+		 * @brief Makes the parser ready for a new connection
+		 */
+		void reset() {
+			_status     = NEED_MORE;
+			_err        = nullptr;
+			_hdr_got    = 0;
+			_rec_left   = 0;
+			_state      = HS_TYPE;
+			_need       = 1;
+			_skip       = false;
+			_acc        = 0;
+			_hs_left    = 0;
+			_ext_left   = 0;
+			_list_left  = 0;
+			_name_type  = 0;
+			_name_len   = 0;
+		}
+
+		/**
+		 * @brief Feeds the next bytes read from the connection
+		 *
+		 * @param data The bytes
+		 * @param size The number of bytes
+		 *
+		 * @return The parser status. Bytes fed after a final status are ignored.
+		 */
+		status feed(const unsigned char *data, size_t size) {
+
+			while (size && _status == NEED_MORE) {
+
+				/* Record header */
+				if (_rec_left == 0) {
+
+					_hdr[_hdr_got++] = *data++;
+					--size;
+
+					if (_hdr_got < sizeof(_hdr))
+						continue;
+
+					_hdr_got = 0;
+
+					if (_hdr[0] != 22)
+						return fail("Not a TLS handshake record.");
+
+					if (_hdr[1] != 3)
+						return fail("Unsupported TLS record version.");
+
+					_rec_left = (static_cast<size_t>(_hdr[3]) << 8) | _hdr[4];
+
+					if (_rec_left == 0 || _rec_left > max_record_size)
+						return fail("Invalid TLS record length.");
+
+					continue;
+				}
+
+				size_t k = ( size < _rec_left ? size : _rec_left );
+				size_t used = handshake(data, k);
+
+				data += used;
+				size -= used;
+				_rec_left -= used;
+			}
+
+			return _status;
+		}
+
+		/// Convenience overload
+		status feed(const char *data, size_t size) {
+			return feed(reinterpret_cast<const unsigned char *>(data), size);
+		}
+
+		inline status get_status() const { return _status; }
+
+		inline bool has_error() const { return _status == FAILED; }
+
+		/// The error description, or an empty string
+		inline const char * error() const { return _err ? _err : ""; }
+
+		/// The server name, not null terminated. Valid when FOUND.
+		inline const char * server_name() const { return _name; }
+
+		/// The server name size
+		inline size_t server_name_size() const { return _status == FOUND ? _name_len : 0; }
+
+	private:
+
+		static constexpr size_t max_record_size = (1 << 14) + 2048;
+
+		/* Handshake fields, in order */
+		enum field {
+			HS_TYPE,
+			HS_LENGTH,
+			VERSION,
+			RANDOM,
+			SESSION_ID_LEN,
+			SESSION_ID,
+			CIPHERS_LEN,
+			CIPHERS,
+			COMPRESSION_LEN,
+			COMPRESSION,
+			EXTENSIONS_LEN,
+			EXT_TYPE,
+			EXT_LEN,
+			EXT_DATA,
+			SNI_LIST_LEN,
+			SNI_NAME_TYPE,
+			SNI_NAME_LEN,
+			SNI_NAME,
+			SNI_SKIP
+		};
+
+		status fail(const char *err) {
+			_status = FAILED;
+			_err = err;
+			return _status;
+		}
+
+		bool reject(const char *err) {
+			fail(err);
+			return false;
+		}
+
+		/* Sets up the next field, checking it fits its enclosing structures */
+		bool next(field f, size_t size, bool skip = false) {
+
+			if (size > _hs_left)
+				return reject("Field exceeds the ClientHello length.");
+
+			_hs_left -= size;
+
+			if (f > EXTENSIONS_LEN) {
+				if (size > _ext_left)
+					return reject("Field exceeds the extensions length.");
+				_ext_left -= size;
+			}
+
+			if (f > EXT_DATA) {
+				if (size > _list_left)
+					return reject("Field exceeds the server name list length.");
+				_list_left -= size;
+			}
+
+			_state = f;
+			_need = size;
+			_skip = skip;
+			_acc = 0;
+
+			/* Empty field */
+			if (size == 0)
+				return done();
+
+			return true;
+		}
+
+		/* Consumes handshake bytes, returns how many were used */
+		size_t handshake(const unsigned char *data, size_t size) {
+
+			size_t used = 0;
+
+			while (used < size && _status == NEED_MORE) {
+
+				size_t k = size - used;
+				if (k > _need)
+					k = _need;
+
+				if (_skip) {
+					/* Nothing to look at */
+				} else if (_state == SNI_NAME) {
+					std::memcpy(_name + _name_len, data + used, k);
+					_name_len += k;
+				} else {
+					for (size_t i = 0; i < k; ++i)
+						_acc = (_acc << 8) | data[used + i];
+				}
+
+				used += k;
+				_need -= k;
+
+				if (_need == 0)
+					done();
+			}
+
+			return used;
+		}
+
+		/* A field is complete */
+		bool done() {
+
+			switch (_state) {
+
+				case HS_TYPE:
+					if (_acc != 1)
+						return reject("Not a ClientHello handshake message.");
+					_hs_left = 3;
+					return next(HS_LENGTH, 3);
+
+				case HS_LENGTH:
+					if (_acc > max_hello_size)
+						return reject("ClientHello too big.");
+					_hs_left = _acc;
+					return next(VERSION, 2);
+
+				case VERSION:
+					if ((_acc >> 8) != 3)
+						return reject("Unsupported ClientHello version.");
+					return next(RANDOM, 32, true);
+
+				case RANDOM:
+					return next(SESSION_ID_LEN, 1);
+
+				case SESSION_ID_LEN:
+					if (_acc > 32)
+						return reject("Session id too long.");
+					return next(SESSION_ID, _acc, true);
+
+				case SESSION_ID:
+					return next(CIPHERS_LEN, 2);
+
+				case CIPHERS_LEN:
+					if (_acc < 2 || (_acc & 1))
+						return reject("Invalid cipher suites length.");
+					return next(CIPHERS, _acc, true);
+
+				case CIPHERS:
+					return next(COMPRESSION_LEN, 1);
+
+				case COMPRESSION_LEN:
+					if (_acc < 1)
+						return reject("Invalid compression methods length.");
+					return next(COMPRESSION, _acc, true);
+
+				case COMPRESSION:
+					/* No extensions at all */
+					if (_hs_left == 0) {
+						_status = NO_SNI;
+						return false;
+					}
+					return next(EXTENSIONS_LEN, 2);
+
+				case EXTENSIONS_LEN:
+					if (_acc != _hs_left)
+						return reject("Invalid extensions length.");
+					_ext_left = _acc;
+					return next_extension();
+
+				case EXT_TYPE:
+					_ext_type = static_cast<uint16_t>(_acc);
+					return next(EXT_LEN, 2);
+
+				case EXT_LEN:
+					if (_ext_type == 0) {
+						if (_acc < 2 || _acc > _ext_left)
+							return reject("Invalid server name extension length.");
+						_list_left = _acc;
+						return next(SNI_LIST_LEN, 2);
+					}
+					return next(EXT_DATA, _acc, true);
+
+				case EXT_DATA:
+					return next_extension();
+
+				case SNI_LIST_LEN:
+					if (_acc != _list_left)
+						return reject("Invalid server name list length.");
+					return next_name();
+
+				case SNI_NAME_TYPE:
+					_name_type = static_cast<unsigned>(_acc);
+					return next(SNI_NAME_LEN, 2);
+
+				case SNI_NAME_LEN:
+					if (_name_type != 0)
+						return next(SNI_SKIP, _acc, true);
+					if (_acc == 0 || _acc > dns::domain::max_name_size)
+						return reject("Invalid server name length.");
+					_name_len = 0;
+					return next(SNI_NAME, _acc);
+
+				case SNI_NAME:
+					if (! dns::domain::is_ldh_name(_name, _name_len))
+						return reject("Invalid server name.");
+					_status = FOUND;
+					return false;
+
+				case SNI_SKIP:
+					return next_name();
+			}
+
+			return false;
+		}
+
+		bool next_extension() {
+
+			if (_ext_left == 0) {
+				_status = NO_SNI;
+				return false;
+			}
+
+			return next(EXT_TYPE, 2);
+		}
+
+		bool next_name() {
+
+			/* A server name list without a host name */
+			if (_list_left == 0) {
+				_status = NO_SNI;
+				return false;
+			}
+
+			return next(SNI_NAME_TYPE, 1);
+		}
+
+		status         _status;
+		const char *   _err;
+
+		unsigned char  _hdr[5];
+		size_t         _hdr_got;
+		size_t         _rec_left;
+
+		field          _state;
+		size_t         _need;
+		bool           _skip;
+		uint32_t       _acc;
+
+		size_t         _hs_left;
+		size_t         _ext_left;
+		size_t         _list_left;
+		uint16_t       _ext_type = 0;
+		unsigned       _name_type;
+
+		char           _name[dns::domain::max_name_size];
+		size_t         _name_len;
+
+};
+
+/**
+ * @class san_matcher
+ * @brief Matches host names against a certificate subject alternative name set
+ *
+ * The DNS names of the set are lowercased and hashed by the name they cover:
+ * the whole name, or the parent name for a wildcard. A lookup costs two hash
+ * probes, one for the host and one for its parent, whatever the set size.
+ *
+ * Wildcards follow RFC 6125: only a whole leftmost "*" label, matching exactly
+ * one host label, with at least two labels after it. Other names with a '*' and
+ * invalid names are ignored, as they can never be matched.
+ *
+ * The matcher is immutable after being built; concurrent lookups are safe.
+ */
+class san_matcher {
+
+	public:
+
+		/**
+		 * @brief Builds the matcher from the certificate DNS names
+		 *
+		 * @param sans The names (e.g. "example.com", "*.example.com")
+		 */
+		san_matcher(const std::vector<std::string> &sans) {
+
+			std::unordered_map<std::string, uint32_t> keys;
+
+			for (const auto &san : sans)
+				add(san, keys);
+
+			/* Power of two, at most half full */
+			size_t cap = 16;
+			while (cap < _entries.size() * 2)
+				cap <<= 1;
+
+			_slots.assign(cap, static_cast<uint32_t>(npos));
+
+			for (size_t i = 0; i < _entries.size(); ++i) {
+
+				size_t pos = _entries[i].hash & (cap - 1);
+
+				while (_slots[pos] != npos)
+					pos = (pos + 1) & (cap - 1);
+
+				_slots[pos] = static_cast<uint32_t>(i);
+			}
+		}
+
+		/**
+		 * @brief Finds the name matching a host
+		 *
+		 * @param host The host name, a trailing dot is allowed
+		 * @param n    The host name size
+		 *
+		 * @return The matching name (lowercase), or nullptr if none matches.
+		 */
+		const std::string * match(const char *host, size_t n) const {
+
+			if (n && host[n - 1] == '.')
+				--n;
+
+			if (n == 0 || _entries.empty())
+				return nullptr;
+
+			const entry *e = probe(host, n);
+			if (e && e->exact != npos)
+				return &_names[e->exact];
+
+			/* The wildcard stands for exactly the first label */
+			const char *dot = static_cast<const char *>(std::memchr(host, '.', n));
+			if (dot == nullptr || dot == host)
+				return nullptr;
+
+			size_t label = static_cast<size_t>(dot - host);
+			if (std::memchr(host, '*', label))
+				return nullptr;
+
+			e = probe(dot + 1, n - label - 1);
+			if (e && e->wildcard != npos)
+				return &_names[e->wildcard];
+
+			return nullptr;
+		}
+
+		/**
+		 * @brief Finds the name matching a host
+		 *
+		 * @return The matching name (lowercase), or nullptr if none matches.
+		 */
+		inline const std::string * match(const std::string &host) const {
+			return match(host.data(), host.size());
+		}
+
+		/// The number of names used
+		inline size_t size() const { return _names.size(); }
+
+		/// The number of names ignored
+		inline size_t ignored() const { return _ignored; }
+
+	private:
+
+		static constexpr uint32_t npos = 0xFFFFFFFF;
+
+		/* A name covered by the set: exactly, by a wildcard, or both */
+		struct entry {
+			std::string key;
+			uint64_t    hash     = 0;
+			uint32_t    exact    = npos;
+			uint32_t    wildcard = npos;
+		};
+
+		void add(const std::string &san, std::unordered_map<std::string, uint32_t> &keys) {
+
+			std::string name(san);
+
+			if (! name.empty() && name.back() == '.')
+				name.pop_back();
+
+			ascii::lower(name);
+
+			bool wildcard = ( name.size() > 2 && name[0] == '*' && name[1] == '.' );
+			std::string key = name.substr(wildcard ? 2 : 0);
+
+			/* A wildcard needs at least two labels after it */
+			if (  key.find('*') != std::string::npos
+			   || ! dns::domain::is_ldh_name(key.data(), key.size())
+			   || ( wildcard && key.find('.') == std::string::npos ) ) {
+				++_ignored;
+				return;
+			}
+
+			auto it = keys.find(key);
+			if (it == keys.end()) {
+				it = keys.emplace(key, static_cast<uint32_t>(_entries.size())).first;
+				_entries.emplace_back();
+				_entries.back().key = key;
+				_entries.back().hash = cm::hash::fnv1a64_lower(key.data(), key.size());
+			}
+
+			entry &e = _entries[it->second];
+			uint32_t &index = ( wildcard ? e.wildcard : e.exact );
+
+			/* Duplicates */
+			if (index != npos)
+				return;
+
+			index = static_cast<uint32_t>(_names.size());
+			_names.emplace_back(std::move(name));
+		}
+
+		const entry * probe(const char *p, size_t n) const {
+
+			uint64_t h = cm::hash::fnv1a64_lower(p, n);
+			size_t mask = _slots.size() - 1;
+
+			for (size_t pos = h & mask; _slots[pos] != npos; pos = (pos + 1) & mask) {
+
+				const entry &e = _entries[_slots[pos]];
+
+				if (e.hash != h || e.key.size() != n)
+					continue;
+
+				size_t i = 0;
+				while (i < n && ascii::lower(p[i]) == e.key[i])
+					++i;
+
+				if (i == n)
+					return &e;
+			}
+
+			return nullptr;
+		}
+
+		std::vector<std::string> _names;
+		std::vector<entry>       _entries;
+		std::vector<uint32_t>    _slots;
+		size_t                   _ignored = 0;
+
+};
+
+}//namespace tls
+}//namespace cm
+
+#endif //_CM_TLS_
@@ -0,0 +1,516 @@
+#ifndef _CM_SMTP_TYPO_
+#define _CM_SMTP_TYPO_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+#include <cm/validator.h>
+#include <cm/ascii.h>
+#include <cm/hash.h>
+#include <cm/domain.h>
+#include <cm/mapped_file.h>
+
+/*
+
+	Symmetric delete spelling correction
+
+	Every popular domain is indexed by the hashes of the strings obtained by
+	deleting up to two of its characters, "gmail.com" gives "mail.com", "gail.com",
+	"gmil.com", ... A typed domain generates its own deletes and each one is
+	probed. Two strings within edit distance two always share a delete, so the
+	probes find every candidate without looking at the whole list.
+
+	Candidates are then ranked by their optimal string alignment distance, where
+	swapping two adjacent characters costs one ("gmial.com" is one edit away).
+
+	Index file - all integers are 32 bit little endian
+
+	magic "CMTY" | version | name_count | names_size | key_count | posting_count
+	name offsets[name_count + 1] | names[names_size]
+	keys[key_count] : delete hash (64 bit) | posting count, by increasing hash
+	postings[posting_count] : name index, in key order
+
+	Only the deletes are stored; the hash table is rebuilt when loading.
+
+*/
+
+namespace cm {
+namespace smtp {
+
+/**
+ * @class typo_index
+ * @brief Suggests a popular email domain for a misspelled one
+ *
+ * Finds the popular domains within edit distance two of a domain in a few
+ * hash probes, whatever the list size. The list order is the popularity
+ * order and breaks ties between candidates at the same distance.
+ *
+ * The index is immutable after being built or loaded; concurrent lookups are safe.
+ *
+ * Does not throw any exception when loading an index file.
+ * Caller must check the typo_index::has_error().
+ */
+class typo_index : public error_check {
+
+	public:
+
+		typedef std::shared_ptr<typo_index> ptr;
+
+		/// The maximum edit distance of a suggestion
+		static constexpr unsigned max_distance = 2;
+
+		/// A suggested domain
+		struct suggestion {
+			const std::string * domain;   ///< The popular domain, lowercase
+			unsigned            distance; ///< The edit distance to the typed domain
+		};
+
+		/**
+		 * @brief Builds the index from a list of popular domains
+		 *
+		 * @param domains The domains, most popular first (e.g. "gmail.com")
+		 *
+		 * @throw dns::exceptions::invalid_domain if a name is not a valid domain
+		 */
+		typo_index(const std::vector<std::string> &domains) {
+
+			std::unordered_map<uint64_t, std::vector<uint32_t>> deletes;
+			std::vector<uint64_t> hashes;
+
+			for (const auto &d : domains) {
+
+				dns::domain checked(d);
+				if (checked.has_error())
+					throw dns::exceptions::invalid_domain(checked.error());
+
+				std::string name(d);
+				ascii::lower(name);
+
+				uint32_t index = static_cast<uint32_t>(_names.size());
+				_names.emplace_back(std::move(name));
+
+				hashes.clear();
+				for_each_delete(_names.back().data(), _names.back().size(), [&hashes](uint64_t h) {
+					hashes.push_back(h);
+				});
+
+				std::sort(hashes.begin(), hashes.end());
+				hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+				for (uint64_t h : hashes)
+					deletes[h].push_back(index);
+			}
+
+			std::vector<std::pair<uint64_t, uint32_t>> keys;
+
+			for (const auto &entry : deletes)
+				keys.emplace_back(entry.first, 0);
+
+			/* Sorted by hash in the index file */
+			std::sort(keys.begin(), keys.end());
+
+			for (auto &k : keys) {
+				const std::vector<uint32_t> &names = deletes[k.first];
+				k.second = static_cast<uint32_t>(names.size());
+				_postings.insert(_postings.end(), names.begin(), names.end());
+			}
+
+			build(keys);
+		}
+
+		/**
+		 * @brief Index object factory method
+		 *
+		 * Loads and checks an index file written by typo_index::save().
+		 *
+		 * @param path The index file path
+		 *
+		 * @return The shared pointer
+		 */
+		static ptr open(const std::string &path) {
+
+			ptr index(new typo_index(std::vector<std::string>()));
+
+			mapped_file f(path);
+
+			if (f.has_error())
+				index->set_error(f);
+			else
+				index->load(reinterpret_cast<const unsigned char *>(f.data()), f.size());
+
+			return index;
+		}
+
+		/**
+		 * @brief Writes the index to a file, to be loaded with typo_index::open()
+		 *
+		 * @return false if the file could not be written.
+		 */
+		bool save(const std::string &path) const {
+
+			std::string out("CMTY");
+
+			size_t names_size = 0;
+			for (const auto &n : _names)
+				names_size += n.size();
+
+			put(out, version);
+			put(out, _names.size());
+			put(out, names_size);
+			put(out, _keys);
+			put(out, _postings.size());
+
+			size_t offset = 0;
+			put(out, offset);
+			for (const auto &n : _names)
+				put(out, offset += n.size());
+
+			for (const auto &n : _names)
+				out += n;
+
+			/* Postings are in hash order */
+			std::vector<slot> keys;
+			for (const auto &s : _slots)
+				if (s.count)
+					keys.push_back(s);
+
+			std::sort(keys.begin(), keys.end(), [](const slot &a, const slot &b) {
+				return a.first < b.first;
+			});
+
+			for (const auto &k : keys) {
+				put(out, k.hash & 0xFFFFFFFF);
+				put(out, k.hash >> 32);
+				put(out, k.count);
+			}
+
+			for (uint32_t p : _postings)
+				put(out, p);
+
+			std::ofstream f(path, std::ios::binary | std::ios::trunc);
+			f.write(out.data(), static_cast<std::streamsize>(out.size()));
+
+			return static_cast<bool>(f);
+		}
+
+		/**
+		 * @brief Finds the popular domains close to a domain
+		 *
+		 * A domain in the list has no suggestion.
+		 *
+		 * @param domain The typed domain
+		 * @param out    The suggestions, nearest and most popular first
+		 * @param max    The maximum number of suggestions
+		 *
+		 * @return The number of suggestions.
+		 */
+		size_t suggest(const std::string &domain, std::vector<suggestion> &out, size_t max = 3) const {
+
+			out.clear();
+
+			if (has_error() || _slots.empty() || domain.empty() || domain.size() > dns::domain::max_name_size)
+				return 0;
+
+			char typed[dns::domain::max_name_size];
+			size_t n = domain.size();
+
+			for (size_t i = 0; i < n; ++i)
+				typed[i] = ascii::lower(domain[i]);
+
+			bool known = false;
+
+			for_each_delete(typed, n, [&](uint64_t h) {
+
+				const slot *s = probe(h);
+				if (s == nullptr || known)
+					return;
+
+				for (uint32_t i = s->first; i < s->first + s->count; ++i) {
+
+					const std::string *name = &_names[_postings[i]];
+
+					bool seen = false;
+					for (const auto &o : out)
+						seen = seen || o.domain == name;
+
+					if (seen)
+						continue;
+
+					unsigned d = distance(typed, n, name->data(), name->size());
+
+					if (d == 0)
+						known = true;
+					else if (d <= max_distance)
+						out.push_back(suggestion{ name, d });
+				}
+			});
+
+			if (known)
+				out.clear();
+
+			/* Names are stored in list order, which is the popularity order */
+			std::sort(out.begin(), out.end(), [](const suggestion &a, const suggestion &b) {
+				return a.distance != b.distance ? a.distance < b.distance : a.domain < b.domain;
+			});
+
+			if (out.size() > max)
+				out.resize(max);
+
+			return out.size();
+		}
+
+		/**
+		 * @brief Finds the best popular domain close to a domain
+		 *
+		 * @return The domain, or nullptr if there is none.
+		 */
+		const std::string * suggest(const std::string &domain) const {
+
+			std::vector<suggestion> out;
+
+			if (suggest(domain, out, 1) == 0)
+				return nullptr;
+
+			return out.front().domain;
+		}
+
+		/**
+		 * @brief Finds the best popular domain close to a domain
+		 *
+		 * @return The domain, or nullptr if there is none or the domain has an error.
+		 */
+		const std::string * suggest(const dns::domain &domain) const {
+
+			if (domain.has_error())
+				return nullptr;
+
+			return suggest(domain.value());
+		}
+
+		/// The number of popular domains
+		inline size_t size() const { return _names.size(); }
+
+	private:
+
+		static constexpr uint32_t version = 1;
+
+		struct slot {
+			uint64_t hash  = 0;
+			uint32_t first = 0;
+			uint32_t count = 0;
+		};
+
+		/* FNV-1a of a string without the characters at i and j, n if none */
+		static uint64_t hash(const char *p, size_t n, size_t i, size_t j) {
+
+			uint64_t h = cm::hash::fnv1a64(p, i);
+
+			if (i < n)
+				h = cm::hash::fnv1a64_append(h, p + i + 1, j - i - 1);
+
+			if (j < n)
+				h = cm::hash::fnv1a64_append(h, p + j + 1, n - j - 1);
+
+			return h;
+		}
+
+		/* Calls f with the hash of the string and of its one and two character deletes */
+		template <typename F>
+		static void for_each_delete(const char *p, size_t n, F f) {
+
+			f(hash(p, n, n, n));
+
+			for (size_t i = 0; i < n; ++i) {
+
+				/* Deleting any character of a run gives the same string */
+				if (i && p[i] == p[i - 1])
+					continue;
+
+				f(hash(p, n, i, n));
+
+				for (size_t j = i + 1; j < n; ++j)
+					if (j == i + 1 || p[j] != p[j - 1])
+						f(hash(p, n, i, j));
+			}
+		}
+
+		/* Optimal string alignment distance, capped at max_distance + 1 */
+		static unsigned distance(const char *a, size_t an, const char *b, size_t bn) {
+
+			if (( an > bn ? an - bn : bn - an ) > max_distance)
+				return max_distance + 1;
+
+			/* Three rows of the distance matrix */
+			unsigned rows[3][dns::domain::max_name_size + 1];
+			unsigned *prev2 = rows[0];
+			unsigned *prev  = rows[1];
+			unsigned *cur   = rows[2];
+
+			for (size_t j = 0; j <= bn; ++j)
+				prev[j] = static_cast<unsigned>(j);
+
+			for (size_t i = 1; i <= an; ++i) {
+
+				cur[0] = static_cast<unsigned>(i);
+				unsigned best = cur[0];
+
+				for (size_t j = 1; j <= bn; ++j) {
+
+					unsigned cost = ( a[i - 1] == b[j - 1] ? 0 : 1 );
+					unsigned d = prev[j - 1] + cost;
+
+					if (prev[j] + 1 < d)
+						d = prev[j] + 1;
+					if (cur[j - 1] + 1 < d)
+						d = cur[j - 1] + 1;
+					if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1] && prev2[j - 2] + 1 < d)
+						d = prev2[j - 2] + 1;
+
+					cur[j] = d;
+					if (d < best)
+						best = d;
+				}
+
+				if (best > max_distance)
+					return max_distance + 1;
+
+				unsigned *t = prev2;
+				prev2 = prev;
+				prev = cur;
+				cur = t;
+			}
+
+			return prev[bn];
+		}
+
+		const slot * probe(uint64_t h) const {
+
+			size_t mask = _slots.size() - 1;
+
+			for (size_t pos = h & mask; _slots[pos].count; pos = (pos + 1) & mask)
+				if (_slots[pos].hash == h)
+					return &_slots[pos];
+
+			return nullptr;
+		}
+
+		static void put(std::string &out, uint64_t v) {
+			for (int i = 0; i < 4; ++i)
+				out += static_cast<char>((v >> (8 * i)) & 0xFF);
+		}
+
+		static uint32_t get(const unsigned char *p) {
+			return   static_cast<uint32_t>(p[0])
+			       | static_cast<uint32_t>(p[1]) << 8
+			       | static_cast<uint32_t>(p[2]) << 16
+			       | static_cast<uint32_t>(p[3]) << 24;
+		}
+
+		/* Builds the hash table of deletes, postings are in key order */
+		void build(const std::vector<std::pair<uint64_t, uint32_t>> &keys) {
+
+			/* Power of two, at most half full */
+			size_t cap = 16;
+			while (cap < keys.size() * 2)
+				cap <<= 1;
+
+			_slots.assign(cap, slot());
+			_keys = keys.size();
+
+			uint32_t first = 0;
+
+			for (const auto &k : keys) {
+
+				size_t pos = k.first & (cap - 1);
+
+				while (_slots[pos].count)
+					pos = (pos + 1) & (cap - 1);
+
+				_slots[pos].hash  = k.first;
+				_slots[pos].first = first;
+				_slots[pos].count = k.second;
+
+				first += k.second;
+			}
+		}
+
+		void load(const unsigned char *p, size_t size) {
+
+			const unsigned char *end = p + size;
+
+			error_check_assert(size < 24 || std::memcmp(p, "CMTY", 4) != 0, "Not a typo index file.");
+			error_check_assert(get(p + 4) != version, "Unsupported typo index version.");
+
+			size_t name_count    = get(p + 8);
+			size_t names_size    = get(p + 12);
+			size_t key_count     = get(p + 16);
+			size_t posting_count = get(p + 20);
+			p += 24;
+
+			/* 64 bit sums cannot overflow */
+			uint64_t need = 4 * (static_cast<uint64_t>(name_count) + 1) + names_size
+			              + 12 * static_cast<uint64_t>(key_count) + 4 * static_cast<uint64_t>(posting_count);
+
+			error_check_assert(need != static_cast<uint64_t>(end - p), "Invalid typo index size.");
+
+			const unsigned char *offsets = p;
+			const char *names = reinterpret_cast<const char *>(p + 4 * (name_count + 1));
+
+			for (size_t i = 0; i < name_count; ++i) {
+
+				size_t from = get(offsets + 4 * i);
+				size_t to = get(offsets + 4 * i + 4);
+
+				error_check_assert(from > to || to > names_size || to - from > dns::domain::max_name_size,
+						"Invalid typo index name.");
+
+				_names.emplace_back(names + from, to - from);
+			}
+
+			p += 4 * (name_count + 1) + names_size;
+
+			std::vector<std::pair<uint64_t, uint32_t>> keys(key_count);
+			uint64_t total = 0;
+
+			for (auto &k : keys) {
+
+				k.first  = get(p) | static_cast<uint64_t>(get(p + 4)) << 32;
+				k.second = get(p + 8);
+				p += 12;
+
+				error_check_assert(k.second == 0 || ( &k != &keys[0] && k.first <= (&k - 1)->first ),
+						"Invalid typo index key.");
+
+				total += k.second;
+			}
+
+			error_check_assert(total != posting_count, "Invalid typo index postings.");
+
+			_postings.resize(posting_count);
+
+			for (auto &i : _postings) {
+				i = get(p);
+				p += 4;
+				error_check_assert(i >= name_count, "Invalid typo index posting.");
+			}
+
+			build(keys);
+		}
+
+		std::vector<std::string> _names;
+		std::vector<slot>        _slots;
+		std::vector<uint32_t>    _postings;
+		size_t                   _keys = 0;
+
+};
+
+}//namespace smtp
+}//namespace cm
+
+#endif //_CM_SMTP_TYPO_
@@ -4,12 +4,19 @@
 #include <string>
 #include <iterator>
 #include <array>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <stdexcept>
 #include <algorithm>
 #include <iostream>
 #include <utility>
 #include <cstring>
+#include <cstdint>
 
 #include <cm/validator.h>
+#include <cm/ascii.h>
+#include <cm/hash.h>
 #include <cm/smtp.h>
 
 
@@ -101,6 +108,59 @@ inline bool is_sub_delims(char c) {
 	return false;
 }
 
+/* RFC 3986 character classes, as bits of one table lookup */
+enum char_class {
+	CC_UNRESERVED = 0x01, // ALPHA / DIGIT / "-" / "." / "_" / "~"
+	CC_SUB_DELIMS = 0x02, // "!" / "$" / "&" / "'" / "(" / ")" / "*" / "+" / "," / ";" / "="
+	CC_PCHAR      = 0x04, // ":" / "@"
+	CC_SLASH      = 0x08, // "/"
+	CC_QUESTION   = 0x10, // "?"
+	CC_ALPHA      = 0x20, // ALPHA
+	CC_DIGIT      = 0x40, // DIGIT
+	CC_HEX        = 0x80  // HEXDIG
+};
+
+/* The 256 entries table, to hoist out of loops */
+inline const unsigned char * char_table() {
+
+	static const struct table {
+
+		unsigned char c[256];
+
+		table() {
+			for (unsigned i = 0; i < 256; ++i) {
+
+				char ch = static_cast<char>(i);
+				unsigned char b = 0;
+
+				if (i < 0x80 && is_unreserved(ch)) b |= CC_UNRESERVED;
+				if (i < 0x80 && is_sub_delims(ch)) b |= CC_SUB_DELIMS;
+				if (ch == ':' || ch == '@')        b |= CC_PCHAR;
+				if (ch == '/')                     b |= CC_SLASH;
+				if (ch == '?')                     b |= CC_QUESTION;
+
+				if ((i >= 'a' && i <= 'z') || (i >= 'A' && i <= 'Z'))
+					b |= CC_ALPHA;
+
+				if (i >= '0' && i <= '9')
+					b |= CC_DIGIT | CC_HEX;
+
+				if ((i >= 'a' && i <= 'f') || (i >= 'A' && i <= 'F'))
+					b |= CC_HEX;
+
+				c[i] = b;
+			}
+		}
+
+	} bits;
+
+	return bits.c;
+}
+
+inline unsigned char char_bits(unsigned char c) {
+	return char_table()[c];
+}
+
 /* TODO: to move this helper functions to elsewhere */
 
 bool icompare_pred(unsigned char a, unsigned char b) {
@@ -122,6 +182,215 @@ bool icase_prefix(const std::string &in, const std::string &prefix) {
 
 }
 
+/**
+ * @namespace cm::url::percent
+ * @brief Percent-encoding kernels, over caller buffers
+ *
+ *	pct-encoded = "%" HEXDIG HEXDIG
+ *
+ * Shared by every URL component. Work on spans instead of one character at a
+ * time: runs without a '%' (percent sign) are found with std::memchr and copied
+ * with std::memcpy, the character classes are one table lookup.
+ */
+namespace percent {
+
+/// Returned by decode() on a bad percent-encoding
+constexpr size_t npos = static_cast<size_t>(-1);
+
+/// The value of a HEXDIG, undefined for other characters
+inline unsigned hex_value(char c) {
+	unsigned char u = static_cast<unsigned char>(c);
+	return ( u & 0x0F ) + ( u >> 6 ) * 9;
+}
+
+/// Checks if a valid percent-encoding starts at a position
+inline bool is_encoded(const char *in, size_t n, size_t pos) {
+	return pos + 2 < n && in[pos] == '%' &&
+		( details::char_bits(in[pos + 1]) & details::char_bits(in[pos + 2]) & details::CC_HEX );
+}
+
+/**
+ * @brief Skips the characters of a class and the valid percent-encodings
+ *
+ * @param in    The span
+ * @param n     The size
+ * @param mask  The details::char_class bits of the allowed characters
+ * @param extra Another allowed character, if not '\0'
+ *
+ * @return The first position not skipped, n if none. A '%' (percent sign)
+ *         there is a bad percent-encoding.
+ */
+inline size_t scan(const char *in, size_t n, unsigned char mask, char extra = '\0') {
+
+	const unsigned char *bits = details::char_table();
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(in);
+
+	size_t i = 0;
+
+	for (;;) {
+
+		/* Four characters per step while all of them are in the class */
+		while (i + 4 <= n && ( bits[p[i]] & mask ) && ( bits[p[i + 1]] & mask ) &&
+				( bits[p[i + 2]] & mask ) && ( bits[p[i + 3]] & mask ))
+			i += 4;
+
+		while (i < n && ( bits[p[i]] & mask ))
+			++i;
+
+		if (i == n)
+			return n;
+
+		if (in[i] == '%') {
+			if (! is_encoded(in, n, i))
+				return i;
+			i += 3;
+		} else if (extra && in[i] == extra) {
+			++i;
+		} else {
+			return i;
+		}
+	}
+}
+
+/**
+ * @brief Validates a whole component
+ *
+ * @param in        The component
+ * @param n         The size
+ * @param from      The first position to check, after a delimiter
+ * @param mask      The details::char_class bits of the allowed characters
+ * @param extra     Another allowed character, if not '\0'
+ * @param component The component name, for the error
+ * @param check     Where to set the error
+ *
+ * @return false if the component has an error.
+ */
+inline bool validate(const char *in, size_t n, size_t from, unsigned char mask, char extra,
+		const char *component, error_check &check) {
+
+	if (from >= n)
+		return true;
+
+	size_t pos = from + scan(in + from, n - from, mask, extra);
+
+	if (pos == n)
+		return true;
+
+	check.set_error(std::string(in[pos] == '%' ? "Bad percent-encoding" : "Invalid character") +
+			" in " + component + " at position " + std::to_string(pos));
+
+	return false;
+}
+
+/**
+ * @brief Checks the percent-encodings only
+ *
+ * @return The position of the first bad percent-encoding, n if none.
+ */
+inline size_t check(const char *in, size_t n) {
+
+	const char *end = in + n;
+
+	for (const char *p = in; p < end; p += 3) {
+
+		p = static_cast<const char *>(std::memchr(p, '%', static_cast<size_t>(end - p)));
+
+		if (! p)
+			break;
+
+		if (! is_encoded(in, n, static_cast<size_t>(p - in)))
+			return static_cast<size_t>(p - in);
+	}
+
+	return n;
+}
+
+/**
+ * @brief Decodes every percent-encoding
+ *
+ * The output may be the input itself, decoding in place.
+ *
+ * @param in  The span
+ * @param n   The size
+ * @param out The output, at least n bytes
+ *
+ * @return The number of bytes written, percent::npos on a bad percent-encoding.
+ */
+inline size_t decode(const char *in, size_t n, char *out) {
+
+	size_t i = 0;
+	size_t w = 0;
+
+	while (i < n) {
+
+		const char *pct = static_cast<const char *>(std::memchr(in + i, '%', n - i));
+		size_t run = ( pct ? static_cast<size_t>(pct - in) : n ) - i;
+
+		if (out + w != in + i)
+			std::memmove(out + w, in + i, run);
+
+		w += run;
+		i += run;
+
+		if (! pct)
+			break;
+
+		if (! is_encoded(in, n, i))
+			return npos;
+
+		out[w++] = static_cast<char>(( hex_value(in[i + 1]) << 4 ) | hex_value(in[i + 2]));
+		i += 3;
+	}
+
+	return w;
+}
+
+/**
+ * @brief Percent-encodes the characters out of a class
+ *
+ * The hex digits are uppercase, as recommended by RFC 3986 section 2.1.
+ *
+ * @param in   The span
+ * @param n    The size
+ * @param out  The output, at least 3 * n bytes
+ * @param mask The details::char_class bits of the characters kept as they are
+ *
+ * @return The number of bytes written.
+ */
+inline size_t encode(const char *in, size_t n, char *out, unsigned char mask = details::CC_UNRESERVED) {
+
+	static const char digits[] = "0123456789ABCDEF";
+
+	const unsigned char *bits = details::char_table();
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(in);
+
+	size_t i = 0;
+	size_t w = 0;
+
+	while (i < n) {
+
+		size_t start = i;
+
+		while (i < n && ( bits[p[i]] & mask ))
+			++i;
+
+		std::memcpy(out + w, in + start, i - start);
+		w += i - start;
+
+		if (i == n)
+			break;
+
+		out[w++] = '%';
+		out[w++] = digits[p[i] >> 4];
+		out[w++] = digits[p[i] & 0x0F];
+		++i;
+	}
+
+	return w;
+}
+
+}//namespace percent
+
 
 namespace syntax {
 
@@ -147,61 +416,16 @@ class userinfo : public error_check {
 			if (in.empty())
 				return;
 
-			for (size_t i=0; i < in.size() ; ++i) {
-				if (! is_valid_char(in,i)) {
-					if (! has_error())
-					 	set_error( "Invalid character in userinfo at position " +
-								std::to_string(i) );
-					return;
-				}
-			}
+			if (! percent::validate(in.data(), in.size(), 0, CHARS, ':', "userinfo", *this))
+				return;
 
-			/* Make a copy to value if not empty */
-			if (! in.empty())
-				_value = in;
+			_value = in;
 
 		}
 
 	 	inline bool is_valid_char(const std::string &in, size_t &pos) {
-
-			char c = in[pos];
-
-			/* special isolated allowed chars */
-			if (c == ':' ) return true;
-
-			/* unreserved */
-			if (details::is_unreserved(c)) return true;
-
-			/* sub-delims */
-			if (details::is_sub_delims(c))
-				return true;
-
-   	 	// * Percentile encoding i.e. %20
-		 	if (c == '%') {
-
-		 	 	// Not enough space for a percentile encdoing. Too close to local part end
-		 	 	if ( pos  > (in.size() - 2) ) {
-		 	 		//TODO: to re-check this
-
-		 	 		set_error ("Percentile encoding too late in non_hier at position "
-		 	 				+ std::to_string(pos) );
-
-					return false;
-		 	 	}
-
-		 	 	// Not hex chars right afer percent sign
-		 	 	if ( ! std::isxdigit(in[pos+1])  || ! std::isxdigit(in[pos+2]) ) {
-		 	 		set_error("Bad Percentile encoding in non_hier at position "
-		 	 				+ std::to_string(pos) );
-					return false;
-		 	 	}
-
-				return true;
-
-		 	}
-
-		 	return false;
-
+			return ( details::char_bits(in[pos]) & CHARS ) || in[pos] == ':' ||
+				percent::is_encoded(in.data(), in.size(), pos);
 		}
 
 
@@ -212,6 +436,10 @@ class userinfo : public error_check {
 		inline const std::string &value() const { return _value; }
 
 	private:
+
+		/* unreserved / sub-delims, and ":" */
+		static constexpr unsigned char CHARS = details::CC_UNRESERVED | details::CC_SUB_DELIMS;
+
 		std::string _value;
 
 };//class userinfo
@@ -258,59 +486,16 @@ class path : public error_check {
 
 			error_check_assert(in.front() != '/', "Path does not begin with a '/' (slash) character.");
 
-			for (size_t i=1; i < in.size() ; ++i) {
-				if (! is_valid_char(in,i)) {
-					if (! has_error())
-					 	set_error( "Invalid character in non_hier at position " +
-								std::to_string(i) );
-					return;
-				}
-			}
+			if (! percent::validate(in.data(), in.size(), 1, CHARS, '\0', "path", *this))
+				return;
 
-			/* Make a copy to value if not empty */
-			if (! in.empty())
-				_value = in;
+			_value = in;
 
 		}
 
 		inline bool is_valid_char(const std::string &in, size_t &pos) {
-
-			char c = in[pos];
-
-			/* special isolated allowed chars */
-			if (c == ':' || c == '@' ) return true;
-
-			/* unreserved */
-			if (details::is_unreserved(c)) return true;
-
-			/* sub-delims */
-			if (details::is_sub_delims(c))
-				return true;
-
-			// * Percentile encoding i.e. %20
-			if (c == '%') {
-
-				// Not enough space for a percentile encdoing. Too close to local part end
-				if ( pos  > (in.size() - 2) ) {
-					//TODO: to re-check this
-
-					set_error ("Percentile encoding too late in non_hier at position "
-							+ std::to_string(pos) );
-
-					return false;
-				}
-
-				// Not hex chars right afer percent sign
-				if ( ! std::isxdigit(in[pos+1])  || ! std::isxdigit(in[pos+2]) ) {
-					set_error("Bad Percentile encoding in non_hier at position "
-							+ std::to_string(pos) );
-					return false;
-				}
-
-			}
-
-			return false;
-
+			return ( details::char_bits(in[pos]) & CHARS ) ||
+				percent::is_encoded(in.data(), in.size(), pos);
 		}
 
 
@@ -321,6 +506,11 @@ class path : public error_check {
 		inline const std::string &value() const { return _value; }
 
 	private:
+
+		/* "/" segments of pchar */
+		static constexpr unsigned char CHARS = details::CC_UNRESERVED | details::CC_SUB_DELIMS |
+			details::CC_PCHAR | details::CC_SLASH;
+
 		std::string _value;
 
 };//class path
@@ -352,15 +542,9 @@ class non_hier : public error_check {
 			if (in.empty())
 				return;
 
-			for (size_t i=1; i < in.size() ; ++i) {
-				if (! is_valid_char(in,i)) {
-					if (! has_error())
-						set_error( "Invalid character in non_hier at position " +
-								std::to_string(i) );
-
-					return;
-				}
-			}
+			/* Skips the hash ('#') or question mark ('?') character */
+			if (! percent::validate(in.data(), in.size(), 1, CHARS, '\0', "non_hier", *this))
+				return;
 
 			_value = in;
 
@@ -372,45 +556,8 @@ class non_hier : public error_check {
 
 
 		inline bool is_valid_char(const std::string &in, size_t &pos) {
-
-			char c = in[pos];
-
-			/* special isolated allowed chars */
-			if (c == '/' || c == '?' || c == ':' || c == '@' ) return true;
-
-			/* unreserved */
-			if (details::is_unreserved(c)) return true;
-
-			/* sub-delims */
-			if (details::is_sub_delims(c))
-				return true;
-
-			// * Percentile encoding i.e. %20
-			if (c == '%') {
-
-				// Not enough space for a percentile encdoing. Too close to local part end
-				if ( pos  > (in.size() - 2) ) {
-					//TODO: to re-check this
-
-					set_error ("Percentile encoding too late in non_hier at position "
-							+ std::to_string(pos) );
-
-					return false;
-				}
-
-				// Not hex chars right afer percent sign
-				if ( ! std::isxdigit(in[pos+1])  || ! std::isxdigit(in[pos+2]) ) {
-					set_error("Bad Percentile encoding in non_hier at position "
-							+ std::to_string(pos) );
-					return false;
-				}
-
-				return true;
-
-			}
-
-			return false;
-
+			return ( details::char_bits(in[pos]) & CHARS ) ||
+				percent::is_encoded(in.data(), in.size(), pos);
 		}
 
 
@@ -421,6 +568,11 @@ class non_hier : public error_check {
 		inline const std::string &value() const { return _value; }
 
 	private:
+
+		/* pchar / "/" / "?" */
+		static constexpr unsigned char CHARS = details::CC_UNRESERVED | details::CC_SUB_DELIMS |
+			details::CC_PCHAR | details::CC_SLASH | details::CC_QUESTION;
+
 		std::string _value;
 
 };//class non_hier
@@ -589,6 +741,34 @@ class mailto : public error_check {
 
 };//class mailto
 
+/**
+ * @brief Opaque URI syntax, as in 'data', 'tel' and 'urn'
+ *
+ * http://tools.ietf.org/html/rfc3986#section-3.3
+ *
+ *	opaque = path-rootless [ "?" query ]
+ *	       = 1*( pchar / "/" / "?" )
+ *
+ * urn:isbn:0451450523
+ */
+class opaque : public error_check {
+
+	public:
+
+	opaque(const std::string &in) {
+
+		error_check_assert(in.empty(), "Empty opaque syntax.");
+
+		percent::validate(in.data(), in.size(), 0, CHARS, '\0', "opaque", *this);
+	}
+
+	private:
+
+	static constexpr unsigned char CHARS = details::CC_UNRESERVED | details::CC_SUB_DELIMS |
+		details::CC_PCHAR | details::CC_SLASH | details::CC_QUESTION;
+
+};//class opaque
+
 
 /**
  * @brief generic URL syntax
@@ -838,6 +1018,54 @@ std::ostream & operator<<  ( std::ostream &os, const generic & generic) {
 	return os ;
 }
 
+/**
+ * @brief file URI syntax
+ *
+ * https://tools.ietf.org/html/rfc8089#section-2
+ *
+ *	file-hier-part = ( "//" auth-path ) / local-path
+ *	auth-path      = [ file-auth ] path-absolute
+ *
+ * The authority may be empty, as in file:///etc/hosts, a local file.
+ */
+class file : public error_check {
+
+	public:
+
+	file(const std::string &in) {
+
+		error_check_assert(in.empty(), "Empty file syntax.");
+
+		/* file://host/path */
+		if (in.front() != '/') {
+			generic g(in);
+			error_check_assert(g.has_error(), g.error());
+			return;
+		}
+
+		/* file:///path, without a host */
+		size_t hash = in.find(separator_chars[FRAGMENT]);
+		size_t question = in.find(separator_chars[QUERY]);
+
+		if (question > hash)
+			question = std::string::npos;
+
+		path p(in.substr(0, std::min(question, hash)));
+		error_check_assert(p.has_error(), p.error());
+
+		if (question != std::string::npos) {
+			query q(in.substr(question, hash - question));
+			error_check_assert(q.has_error(), q.error());
+		}
+
+		if (hash != std::string::npos) {
+			fragment f(in.substr(hash));
+			error_check_assert(f.has_error(), f.error());
+		}
+	}
+
+};//class file
+
 }//namespace syntax
 
 /// The enumerated list of allowed schemes ( "protocols") URL's
@@ -849,6 +1077,12 @@ enum schemes {
 	NFS = 4,
 	MAILTO = 5,
 	CID =6,
+	WS = 7,
+	WSS = 8,
+	FILE_URI = 9,  // FILE is the C stdio type
+	DATA = 10,
+	TEL = 11,
+	URN = 12,
 	UNDEF
 };
 
@@ -861,9 +1095,225 @@ constexpr static const char *  schemes_names[] = {
 	"nfs",
 	"mailto",
 	"cid",
+	"ws",
+	"wss",
+	"file",
+	"data",
+	"tel",
+	"urn",
 	nullptr
 };
 
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+/* Binds a syntax class to a scheme_registry::parser */
+template <class S>
+inline bool parse_syntax(const std::string &in, error_check &err) {
+
+	S syn(in);
+
+	if (syn.has_error()) {
+		err.set_error(syn);
+		return false;
+	}
+
+	return true;
+}
+
+} //namespace details
+/// @endcond
+
+/**
+ * @class scheme_registry
+ * @brief The known URL schemes, each bound to its syntax parser
+ *
+ * Holds the built-in schemes and the ones registered by the application.
+ * Lookups are case-insensitive and allocate nothing: a perfect hash of the
+ * names, rebuilt on each registration, gives the only candidate to compare.
+ *
+ *	cm::url::scheme_registry::instance().add("gopher", cm::url::details::parse_syntax<cm::url::syntax::generic>, 70);
+ *
+ * Schemes are meant to be registered at startup: registering is not thread
+ * safe with lookups.
+ */
+class scheme_registry {
+
+	public:
+
+		/// Validates what follows the scheme ':' (colon) and "//", setting the error
+		typedef bool (*parser)(const std::string &in, error_check &err);
+
+		/// A registered scheme
+		struct entry {
+			std::string name;          ///< The lowercase name
+			int         id;            ///< The url::schemes value, above UNDEF for the registered ones
+			uint16_t    default_port;  ///< The default port, 0 if none
+			parser      parse;         ///< The syntax parser
+		};
+
+		/// The registry of the process
+		static scheme_registry & instance() {
+			static scheme_registry registry;
+			return registry;
+		}
+
+		/**
+		 * @brief Registers a scheme
+		 *
+		 * @param name         The name, case-insensitive
+		 * @param parse        The syntax parser
+		 * @param default_port The default port, 0 if none
+		 *
+		 * @return The entry, valid for the process lifetime.
+		 *
+		 * @throw std::invalid_argument if the name is not a scheme name or is already registered
+		 */
+		const entry & add(const std::string &name, parser parse, uint16_t default_port = 0) {
+
+			/* scheme = ALPHA *( ALPHA / DIGIT / "+" / "-" / "." ) */
+			bool valid = ! name.empty() && ( details::char_bits(name[0]) & details::CC_ALPHA );
+
+			for (size_t i = 1; valid && i < name.size(); ++i)
+				valid = ( details::char_bits(name[i]) & ( details::CC_ALPHA | details::CC_DIGIT ) ) ||
+					name[i] == '+' || name[i] == '-' || name[i] == '.';
+
+			if (! valid || parse == nullptr)
+				throw std::invalid_argument("Invalid scheme name.");
+
+			if (find(name))
+				throw std::invalid_argument("Scheme already registered.");
+
+			entry e;
+			e.name.resize(name.size());
+			for (size_t i = 0; i < name.size(); ++i)
+				e.name[i] = ascii::lower(name[i]);
+			e.id = static_cast<int>(UNDEF + 1 + _entries.size() - _builtins);
+			e.default_port = default_port;
+			e.parse = parse;
+
+			_entries.push_back(e);
+			rebuild();
+
+			return _entries.back();
+		}
+
+		/**
+		 * @brief Finds a scheme, case-insensitive
+		 *
+		 * @param name The name, without the ':' (colon)
+		 * @param n    The size
+		 *
+		 * @return The entry, nullptr if not registered.
+		 */
+		const entry * find(const char *name, size_t n) const {
+
+			int16_t slot = _slots[hash(name, n, _seed) & _mask];
+
+			if (slot < 0)
+				return nullptr;
+
+			const entry &e = _entries[static_cast<size_t>(slot)];
+
+			if (e.name.size() != n)
+				return nullptr;
+
+			for (size_t i = 0; i < n; ++i)
+				if (ascii::lower(name[i]) != e.name[i])
+					return nullptr;
+
+			return &e;
+		}
+
+		/// Convenience overload
+		inline const entry * find(const std::string &name) const { return find(name.data(), name.size()); }
+
+		/// The number of schemes
+		inline size_t size() const { return _entries.size(); }
+
+	private:
+
+		scheme_registry() {
+
+			struct builtin { schemes id; uint16_t port; parser parse; };
+
+			static const builtin builtins[] = {
+				{ HTTP,     80,   details::parse_syntax<syntax::generic> },
+				{ HTTPS,    443,  details::parse_syntax<syntax::generic> },
+				{ FTP,      21,   details::parse_syntax<syntax::generic> },
+				{ CAP,      1026, details::parse_syntax<syntax::generic> },
+				{ NFS,      2049, details::parse_syntax<syntax::generic> },
+				{ MAILTO,   0,    details::parse_syntax<syntax::mailto>  },
+				{ CID,      0,    details::parse_syntax<syntax::cid>     },
+				{ WS,       80,   details::parse_syntax<syntax::generic> },
+				{ WSS,      443,  details::parse_syntax<syntax::generic> },
+				{ FILE_URI, 0,    details::parse_syntax<syntax::file>    },
+				{ DATA,     0,    details::parse_syntax<syntax::opaque>  },
+				{ TEL,      0,    details::parse_syntax<syntax::opaque>  },
+				{ URN,      0,    details::parse_syntax<syntax::opaque>  }
+			};
+
+			static_assert(sizeof(builtins) / sizeof(builtins[0]) == UNDEF, "schemes / builtins mismatch");
+
+			for (const builtin &b : builtins) {
+				entry e;
+				e.name = schemes_names[b.id];
+				e.id = b.id;
+				e.default_port = b.port;
+				e.parse = b.parse;
+				_entries.push_back(e);
+			}
+
+			_builtins = _entries.size();
+			rebuild();
+		}
+
+		/* FNV-1a of the lowercase name, mixed: the table index is its low bits */
+		static uint32_t hash(const char *p, size_t n, uint32_t seed) {
+			return static_cast<uint32_t>(cm::hash::fmix64(cm::hash::fnv1a64_lower(p, n, seed)));
+		}
+
+		/* Tries seeds until every name has its own slot, growing the table if needed */
+		void rebuild() {
+
+			size_t size = 16;
+			while (size < 2 * _entries.size())
+				size <<= 1;
+
+			for (;; size <<= 1) {
+
+				for (uint32_t seed = 1; seed <= 1000; ++seed) {
+
+					_slots.assign(size, -1);
+
+					size_t i = 0;
+
+					for (; i < _entries.size(); ++i) {
+
+						int16_t &slot = _slots[hash(_entries[i].name.data(), _entries[i].name.size(), seed) & ( size - 1 )];
+
+						if (slot >= 0)
+							break;
+
+						slot = static_cast<int16_t>(i);
+					}
+
+					if (i == _entries.size()) {
+						_seed = seed;
+						_mask = size - 1;
+						return;
+					}
+				}
+			}
+		}
+
+		std::deque<entry>    _entries;  // references stay valid on push_back
+		std::vector<int16_t> _slots;
+		size_t               _mask = 0;
+		uint32_t             _seed = 0;
+		size_t               _builtins = 0;
+
+};
 
 /**
  * @brief
@@ -881,35 +1331,35 @@ class scheme : public error_check {
 		operator std::string() const { return value(); }
 		operator schemes() const { return id(); }
 		inline const std::string & value() const { return _value; }
+
+		/// The scheme id, UNDEF for the schemes registered by the application
 		inline schemes id() const { return _id; }
 
+		/// The registry entry, nullptr on error
+		inline const scheme_registry::entry * entry() const { return _entry; }
+
 	private:
 
 		scheme(const std::string &name) : _id(UNDEF) {
 
-			constexpr int equal = 0;
-
-			std::string s(name);
-			std::transform(s.begin(), s.end(), s.begin(), ::tolower);
-
-
-			for(size_t i = 0; i < (UNDEF - 1); ++i) {
+			_entry = scheme_registry::instance().find(name);
 
-				if (::strcmp(s.c_str(),schemes_names[i]) == equal ) {
-					_value = s;
-					_id = static_cast<schemes>(i);
-					return;
-				}
+			if (_entry == nullptr) {
+				set_error("Scheme type not found");
+				return;
 			}
 
-			set_error("Scheme type not found");
+			_value = _entry->name;
 
+			if (_entry->id < UNDEF)
+				_id = static_cast<schemes>(_entry->id);
 		}
 
 		friend std::ostream & operator<<  ( std::ostream &os, const scheme & scheme);
 
 		std::string _value;
 		schemes _id;
+		const scheme_registry::entry * _entry = nullptr;
 
 };//class scheme
 
@@ -970,10 +1420,15 @@ class resource : public error_check {
 		if (in[idx] == '/' ) ++idx;
 		if (in[idx] == '/' ) ++idx;
 
-		/* Checks this resource syntax */
+		/* Checks this resource syntax, the registered one of its scheme for resource<> */
 
-		S syn(std::string(in, idx));
-		error_check_assert( syn.has_error() , syn.error());
+		if (s == UNDEF && std::is_same<S, syntax::generic>::value) {
+			if (! _scheme->entry()->parse(std::string(in, idx), *this))
+				return;
+		} else {
+			S syn(std::string(in, idx));
+			error_check_assert( syn.has_error() , syn.error());
+		}
 
 		/* std::cerr << syn << std::endl; */
 
@@ -0,0 +1,125 @@
+#ifndef _CM_URL_FINGERPRINT_
+#define _CM_URL_FINGERPRINT_
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/hash.h>
+#include <cm/url.h>
+#include <cm/url_view.h>
+#include <cm/url_normalize.h>
+
+/*
+
+	URL fingerprint - MurmurHash3 x64 128 of the URL, with a fixed seed and
+	little endian reads: the same URL has the same fingerprint on every
+	platform and in every run, it can be stored.
+
+	Equivalent URLs have the same fingerprint when it is taken over the normal
+	form: HTTP://Example.COM:80/a/../b and http://example.com/b.
+
+*/
+
+namespace cm {
+namespace url {
+
+/// A 128 bit URL fingerprint
+typedef cm::fingerprint128 fingerprint128;
+
+/**
+ * @brief What a fingerprint is taken over
+ */
+struct fingerprint_options {
+
+	/// Over the normal form (url::normalize()), otherwise over the URL as written
+	bool normalize = true;
+
+	/// With the fragment, which does not change the resource fetched
+	bool fragment  = false;
+};
+
+/**
+ * @brief Gets the 128 bit fingerprint of a valid URL
+ *
+ * @param v       The parsed URL
+ * @param scratch A reusable buffer for the normal form
+ * @param opt     What the fingerprint is taken over
+ *
+ * @return The fingerprint, zero if the URL has an error.
+ */
+inline fingerprint128 fingerprint(const view &v, std::string &scratch, const fingerprint_options &opt = fingerprint_options()) {
+
+	if (v.has_error())
+		return fingerprint128();
+
+	const char *p = v.value().data();
+	size_t n = v.value().size();
+
+	if (opt.normalize) {
+
+		normalize(v, scratch);
+		p = scratch.data();
+		n = scratch.size();
+
+		/* The first '#' (hash) of a valid URL starts the fragment */
+		if (! opt.fragment && v.has(FRAGMENT))
+			n = static_cast<size_t>(static_cast<const char *>(std::memchr(p, '#', n)) - p);
+
+	} else if (! opt.fragment && v.has(FRAGMENT)) {
+		n = v.begin(FRAGMENT) - 1;
+	}
+
+	return hash::murmur3_128(p, n);
+}
+
+/// Convenience overload
+inline fingerprint128 fingerprint(const view &v, const fingerprint_options &opt = fingerprint_options()) {
+	std::string scratch;
+	return fingerprint(v, scratch, opt);
+}
+
+/**
+ * @brief Gets the 128 bit fingerprint of a valid resource
+ *
+ * A resource whose syntax is not generic (mailto, cid) is taken as written.
+ *
+ * @return The fingerprint, zero if the resource has an error.
+ */
+template < schemes s, class S >
+inline fingerprint128 fingerprint(const resource<s, S> &r, std::string &scratch, const fingerprint_options &opt = fingerprint_options()) {
+
+	if (r.has_error())
+		return fingerprint128();
+
+	view v(r.value());
+
+	if (v.has_error())
+		return hash::murmur3_128(r.value().data(), r.value().size());
+
+	return fingerprint(v, scratch, opt);
+}
+
+/**
+ * @brief Gets the 64 bit fingerprint of a valid URL
+ *
+ * @return The fingerprint, zero if the URL has an error.
+ */
+inline uint64_t fingerprint64(const view &v, std::string &scratch, const fingerprint_options &opt = fingerprint_options()) {
+	return fingerprint(v, scratch, opt).lo;
+}
+
+/**
+ * @brief Gets the 64 bit fingerprint of a valid resource
+ *
+ * @return The fingerprint, zero if the resource has an error.
+ */
+template < schemes s, class S >
+inline uint64_t fingerprint64(const resource<s, S> &r, std::string &scratch, const fingerprint_options &opt = fingerprint_options()) {
+	return fingerprint(r, scratch, opt).lo;
+}
+
+}//namespace url
+}//namespace cm
+
+#endif //_CM_URL_FINGERPRINT_
@@ -0,0 +1,240 @@
+#ifndef _CM_URL_NORMALIZE_
+#define _CM_URL_NORMALIZE_
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/ascii.h>
+#include <cm/url.h>
+#include <cm/url_view.h>
+
+/*
+
+	Syntax-based normalization - http://tools.ietf.org/html/rfc3986#section-6.2.2
+
+	- Case: scheme and host are lowercased, percent-encoding hex digits uppercased
+	- Percent-encoding: encoded unreserved characters are decoded
+	- Path segments: "." and ".." are removed from hierarchical paths
+
+	Scheme-based normalization - http://tools.ietf.org/html/rfc3986#section-6.2.3
+
+	- An empty port or the scheme default port is removed
+	- An empty path with an authority is "/"
+
+	HTTP://www.Example.COM:80/a/./b/../c/%7euser?q=%3f  =>  http://www.example.com/a/c/~user?q=%3F
+
+*/
+
+namespace cm {
+namespace url {
+
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+/* Copies a valid component, decoding unreserved and uppercasing the other escapes */
+inline size_t copy_normalized(const char *in, size_t n, char *out, bool fold) {
+
+	static const char digits[] = "0123456789ABCDEF";
+	size_t w = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+
+		if (in[i] != '%') {
+			out[w++] = fold ? ascii::lower(in[i]) : in[i];
+			continue;
+		}
+
+		char c = static_cast<char>(( percent::hex_value(in[i + 1]) << 4 ) | percent::hex_value(in[i + 2]));
+
+		if (char_bits(c) & CC_UNRESERVED) {
+			out[w++] = fold ? ascii::lower(c) : c;
+		} else {
+			out[w++] = '%';
+			out[w++] = digits[( c >> 4 ) & 0x0F];
+			out[w++] = digits[c & 0x0F];
+		}
+
+		i += 2;
+	}
+
+	return w;
+}
+
+/* The default port of the registered scheme, 0 if none */
+inline uint16_t default_port(const char *scheme, size_t n) {
+	const scheme_registry::entry *e = scheme_registry::instance().find(scheme, n);
+	return e ? e->default_port : 0;
+}
+
+} //namespace details
+/// @endcond
+
+/**
+ * @brief Writes the normal form of a valid URL
+ *
+ * One pass over the components, writing into a single output buffer. Dot
+ * segments are removed from the path of absolute URLs only, a relative
+ * reference keeps its meaning.
+ *
+ * @param v   The parsed URL
+ * @param out The output, at least v.value().size() + 1 bytes
+ *
+ * @return The number of bytes written, 0 if the URL has an error.
+ */
+inline size_t normalize(const view &v, char *out) {
+
+	if (v.has_error())
+		return 0;
+
+	size_t w = 0;
+
+	size_t scheme = 0;
+
+	if (v.has(SCHEME)) {
+		text_view s = v.get(SCHEME);
+		for (size_t i = 0; i < s.size(); ++i)
+			out[w++] = ascii::lower(s.data()[i]);
+		scheme = w;
+		out[w++] = ':';
+	}
+
+	if (v.has_authority()) {
+
+		out[w++] = '/';
+		out[w++] = '/';
+
+		if (v.has(USERINFO)) {
+			text_view u = v.get(USERINFO);
+			w += details::copy_normalized(u.data(), u.size(), out + w, false);
+			out[w++] = '@';
+		}
+
+		text_view h = v.get(HOST);
+		w += details::copy_normalized(h.data(), h.size(), out + w, true);
+
+		/* Port without leading zeros, dropped if empty or the default one */
+		if (v.has(PORT) && v.get(PORT).size()) {
+
+			uint16_t port = v.port_number();
+
+			if (port != details::default_port(out, scheme)) {
+
+				char digits[5];
+				size_t k = 0;
+
+				do {
+					digits[k++] = static_cast<char>('0' + port % 10);
+					port /= 10;
+				} while (port);
+
+				out[w++] = ':';
+				while (k)
+					out[w++] = digits[--k];
+			}
+		}
+	}
+
+	text_view p = v.get(PATH);
+	const char *path = p.data();
+	size_t n = p.size();
+
+	if (n == 0 && v.has_authority())
+		out[w++] = '/';
+
+	bool dots = v.is_absolute() && n && path[0] == '/';
+	size_t start = w;
+
+	/* Segment by segment, resolving "." and ".." against what was written */
+	for (size_t i = 0; i < n; ) {
+
+		size_t seg = w;
+
+		if (path[i] == '/')
+			out[w++] = path[i++];
+
+		size_t from = i;
+		while (i < n && path[i] != '/')
+			++i;
+
+		size_t content = w;
+		w += details::copy_normalized(path + from, i - from, out + w, false);
+
+		if (! dots)
+			continue;
+
+		size_t len = w - content;
+		bool dot = len == 1 && out[content] == '.';
+		bool dotdot = len == 2 && out[content] == '.' && out[content + 1] == '.';
+
+		if (! dot && ! dotdot)
+			continue;
+
+		w = seg;
+
+		/* ".." drops the previous segment and its slash */
+		if (dotdot) {
+			while (w > start && out[w - 1] != '/')
+				--w;
+			if (w > start)
+				--w;
+		}
+
+		/* "/a/b/.." is "/a/" */
+		if (i >= n)
+			out[w++] = '/';
+	}
+
+	if (v.has(QUERY)) {
+		text_view q = v.get(QUERY);
+		out[w++] = '?';
+		w += details::copy_normalized(q.data(), q.size(), out + w, false);
+	}
+
+	if (v.has(FRAGMENT)) {
+		text_view f = v.get(FRAGMENT);
+		out[w++] = '#';
+		w += details::copy_normalized(f.data(), f.size(), out + w, false);
+	}
+
+	return w;
+}
+
+/**
+ * @brief Gets the normal form of a valid URL
+ *
+ * @param v   The parsed URL
+ * @param out The normal form. Reusing it avoids allocations.
+ *
+ * @return false if the URL has an error.
+ */
+inline bool normalize(const view &v, std::string &out) {
+
+	if (v.has_error()) {
+		out.clear();
+		return false;
+	}
+
+	out.resize(v.value().size() + 1);
+	out.resize(normalize(v, &out[0]));
+
+	return true;
+}
+
+/**
+ * @brief Gets the normal form of a URL
+ *
+ * @param in  The URL
+ * @param out The normal form, empty if the URL has an error
+ *
+ * @return false if the URL has an error.
+ */
+inline bool normalize(const std::string &in, std::string &out) {
+	view v(in);
+	return normalize(v, out);
+}
+
+}//namespace url
+}//namespace cm
+
+#endif //_CM_URL_NORMALIZE_
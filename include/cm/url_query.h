@@ -0,0 +1,323 @@
+#ifndef _CM_URL_QUERY_
+#define _CM_URL_QUERY_
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/url.h>
+#include <cm/url_view.h>
+
+/*
+
+	Query string - http://tools.ietf.org/html/rfc3986#section-3.4
+	               https://www.w3.org/TR/html401/interact/forms.html#h-17.13.4.1
+
+	query       = pair *( ( "&" / ";" ) pair )
+	pair        = key [ "=" value ]
+
+	Keys and values are application/x-www-form-urlencoded: "+" is a space and
+	"%" HEXDIG HEXDIG an encoded byte.
+
+	?utm_source=news&utm_medium=e%2Dmail&q=a+b;empty=&flag
+
+*/
+
+namespace cm {
+namespace url {
+
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+/* Decodes one form-urlencoded character, advancing the position. A bad escape is literal. */
+inline char form_char(const char *in, size_t n, size_t &i) {
+
+	char c = in[i++];
+
+	if (c == '+')
+		return ' ';
+
+	if (c == '%' && percent::is_encoded(in, n, i - 1)) {
+		c = static_cast<char>(( percent::hex_value(in[i]) << 4 ) | percent::hex_value(in[i + 1]));
+		i += 2;
+	}
+
+	return c;
+}
+
+} //namespace details
+/// @endcond
+
+/**
+ * @class query_string
+ * @brief Iterates over the key/value pairs of a query string
+ *
+ * The pairs are views into the query, which the caller keeps while using them.
+ * Keys and values are decoded only when asked for, into a caller buffer, and
+ * only if they have an escape: reading a plain value copies nothing.
+ *
+ *	cm::url::view u(line);
+ *	cm::url::query_string q(u.get(cm::url::QUERY));
+ *	cm::url::query_string::param p;
+ *	std::string scratch;
+ *	while (q.next(p))
+ *		if (p.is("q"))
+ *			use(p.decoded_value(scratch));
+ *
+ * Both '&' (ampersand) and ';' (semicolon) separate pairs, empty pairs are
+ * skipped. Any input is accepted, a bad percent-encoding is kept as it is.
+ */
+class query_string {
+
+	public:
+
+		/// A key/value pair, as written
+		struct param {
+			text_view key;            ///< The key, maybe encoded
+			text_view value;          ///< The value, maybe encoded, empty if none
+			bool      has_value;      ///< If there is a '=' (equals sign), "k=" but not "k"
+			bool      key_encoded;    ///< If the key has a '+' or a '%'
+			bool      value_encoded;  ///< If the value has a '+' or a '%'
+
+			/**
+			 * @brief Compares the decoded key, without decoding it
+			 *
+			 * @param name The decoded key
+			 * @param n    The size
+			 */
+			bool is(const char *name, size_t n) const {
+
+				if (! key_encoded)
+					return key.size() == n && std::memcmp(key.data(), name, n) == 0;
+
+				/* An escape is 1 to 3 characters */
+				if (n > key.size() || n * 3 < key.size())
+					return false;
+
+				size_t i = 0;
+				size_t j = 0;
+
+				while (i < key.size())
+					if (j == n || details::form_char(key.data(), key.size(), i) != name[j++])
+						return false;
+
+				return j == n;
+			}
+
+			/// Compares the decoded key with a C string
+			inline bool is(const char *name) const { return is(name, std::strlen(name)); }
+
+			/**
+			 * @brief The decoded key
+			 *
+			 * @param scratch The buffer used if the key is encoded
+			 *
+			 * @return The key itself if not encoded, a view of scratch otherwise.
+			 */
+			inline text_view decoded_key(std::string &scratch) const { return decode(key, key_encoded, scratch); }
+
+			/**
+			 * @brief The decoded value
+			 *
+			 * @param scratch The buffer used if the value is encoded
+			 *
+			 * @return The value itself if not encoded, a view of scratch otherwise.
+			 */
+			inline text_view decoded_value(std::string &scratch) const { return decode(value, value_encoded, scratch); }
+		};
+
+		/// Maximum number of keys of query_string::find()
+		static constexpr size_t max_keys = 64;
+
+		/**
+		 * @brief Prepares the iteration over a query
+		 *
+		 * @param in The query, with or without its '?' (question mark), kept by the caller
+		 * @param n  The size
+		 */
+		query_string(const char *in, size_t n) : _p(in), _n(n) {
+
+			if (_n && _p[0] == '?') {
+				++_p;
+				--_n;
+			}
+		}
+
+		/// Convenience constructor, as from url::view::get(QUERY)
+		query_string(const text_view &in) : query_string(in.data(), in.size()) {}
+
+		/// Convenience constructor, the C string is kept by the caller
+		query_string(const char *in) : query_string(in, std::strlen(in)) {}
+
+		/// Convenience constructor, as from syntax::query::value()
+		query_string(const std::string &in) : query_string(in.data(), in.size()) {}
+
+		/// A temporary string would not outlive the iteration
+		query_string(std::string &&) = delete;
+
+		/**
+		 * @brief Gets the next pair
+		 *
+		 * @param p The pair found
+		 *
+		 * @return false at the end of the query.
+		 */
+		inline bool next(param &p) { return next(_pos, p); }
+
+		/// Restarts the iteration
+		inline void rewind() { _pos = 0; }
+
+		/**
+		 * @brief Finds the first pair of each wanted key, in one scan
+		 *
+		 * The scan stops as soon as every key is found, the rest of the query is
+		 * not read. Does not change the position of query_string::next().
+		 *
+		 * @param keys  The decoded keys, at most query_string::max_keys
+		 * @param count The number of keys
+		 * @param found The pairs found, by key index. The others are not changed.
+		 *
+		 * @return The mask of the keys found, bit i for keys[i].
+		 */
+		uint64_t find(const char *const keys[], size_t count, param found[]) const {
+
+			if (count > max_keys)
+				count = max_keys;
+
+			size_t sizes[max_keys];
+
+			for (size_t k = 0; k < count; ++k)
+				sizes[k] = std::strlen(keys[k]);
+
+			const uint64_t all = count == max_keys ? ~uint64_t(0) : ( uint64_t(1) << count ) - 1;
+			uint64_t mask = 0;
+
+			size_t pos = 0;
+			param p;
+
+			while (mask != all && next(pos, p)) {
+
+				for (size_t k = 0; k < count; ++k) {
+
+					if (( mask >> k ) & 1)
+						continue;
+
+					if (p.is(keys[k], sizes[k])) {
+						found[k] = p;
+						mask |= uint64_t(1) << k;
+					}
+				}
+			}
+
+			return mask;
+		}
+
+		/**
+		 * @brief Finds the first pair of a key
+		 *
+		 * @param key The decoded key
+		 * @param p   The pair found
+		 *
+		 * @return false if not found.
+		 */
+		bool find(const char *key, param &p) const {
+			const char *keys[] = { key };
+			return find(keys, 1, &p) != 0;
+		}
+
+	private:
+
+		enum char_type {
+			Q_SEPARATOR = 0x01,  ///< '&' and ';'
+			Q_EQUALS    = 0x02,  ///< '='
+			Q_ENCODED   = 0x04   ///< '+' and '%'
+		};
+
+		static text_view decode(const text_view &in, bool encoded, std::string &scratch) {
+
+			if (! encoded)
+				return in;
+
+			scratch.resize(in.size());
+
+			size_t w = 0;
+			for (size_t i = 0; i < in.size(); )
+				scratch[w++] = details::form_char(in.data(), in.size(), i);
+
+			scratch.resize(w);
+
+			return text_view(scratch.data(), w);
+		}
+
+		bool next(size_t &pos, param &p) const {
+
+			static const struct table {
+
+				unsigned char c[256];
+
+				table() {
+					std::memset(c, 0, sizeof(c));
+					c[static_cast<unsigned char>('&')] = Q_SEPARATOR;
+					c[static_cast<unsigned char>(';')] = Q_SEPARATOR;
+					c[static_cast<unsigned char>('=')] = Q_EQUALS;
+					c[static_cast<unsigned char>('+')] = Q_ENCODED;
+					c[static_cast<unsigned char>('%')] = Q_ENCODED;
+				}
+
+			} types;
+
+			const unsigned char *in = reinterpret_cast<const unsigned char *>(_p);
+
+			while (pos < _n) {
+
+				size_t start = pos;
+				size_t eq = _n;
+				bool encoded[2] = { false, false };
+
+				for (; pos < _n; ++pos) {
+
+					unsigned char t = types.c[in[pos]];
+
+					if (! t)
+						continue;
+
+					if (t == Q_SEPARATOR)
+						break;
+
+					if (t == Q_EQUALS && eq == _n)
+						eq = pos;
+					else if (t == Q_ENCODED)
+						encoded[eq != _n] = true;
+				}
+
+				size_t end = pos;
+
+				if (pos < _n)
+					++pos;
+
+				/* "a=1&&b=2" */
+				if (end == start)
+					continue;
+
+				p.has_value = eq != _n;
+				p.key = text_view(_p + start, ( p.has_value ? eq : end ) - start);
+				p.value = p.has_value ? text_view(_p + eq + 1, end - eq - 1) : text_view();
+				p.key_encoded = encoded[0];
+				p.value_encoded = encoded[1];
+
+				return true;
+			}
+
+			return false;
+		}
+
+		const char *_p;
+		size_t      _n;
+		size_t      _pos = 0;
+
+};
+
+}//namespace url
+}//namespace cm
+
+#endif //_CM_URL_QUERY_
@@ -0,0 +1,308 @@
+#ifndef _CM_URL_RESOLVE_
+#define _CM_URL_RESOLVE_
+
+#include <string>
+#include <cstring>
+
+#include <cm/validator.h>
+#include <cm/url.h>
+#include <cm/url_view.h>
+
+/*
+
+	Reference resolution - http://tools.ietf.org/html/rfc3986#section-5.2
+
+	A relative reference takes the missing components from the base URL, its
+	path being merged with the base path directory. Dot segments are then
+	removed (section 5.2.4).
+
+	base  http://a/b/c/d;p?q
+
+	g      =>  http://a/b/c/g
+	../g   =>  http://a/b/g
+	//g    =>  http://g
+	?y     =>  http://a/b/c/d;p?y
+	#s     =>  http://a/b/c/d;p?q#s
+
+*/
+
+namespace cm {
+namespace url {
+
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+inline bool dot_prefix(const char *in, size_t n, size_t i, const char *s, size_t len) {
+	return n - i >= len && std::memcmp(in + i, s, len) == 0;
+}
+
+inline bool dot_rest(const char *in, size_t n, size_t i, const char *s, size_t len) {
+	return n - i == len && std::memcmp(in + i, s, len) == 0;
+}
+
+/* RFC 3986 section 5.2.4. The output may be the input: it never gets ahead of it. */
+inline size_t remove_dot_segments(const char *in, size_t n, char *out) {
+
+	size_t i = 0;
+	size_t w = 0;
+
+	while (i < n) {
+
+		/* A. "../" and "./" prefixes */
+		if (dot_prefix(in, n, i, "../", 3)) { i += 3; continue; }
+		if (dot_prefix(in, n, i, "./", 2))  { i += 2; continue; }
+
+		/* B. "/./" is "/", a final "/." is "/" */
+		if (dot_prefix(in, n, i, "/./", 3)) { i += 2; continue; }
+		if (dot_rest(in, n, i, "/.", 2))    { out[w++] = '/'; break; }
+
+		/* C. "/../" is "/", a final "/.." is "/", both remove the last output segment */
+		bool up = dot_prefix(in, n, i, "/../", 4);
+
+		if (up || dot_rest(in, n, i, "/..", 3)) {
+
+			while (w > 0 && out[w - 1] != '/')
+				--w;
+			if (w > 0)
+				--w;
+
+			if (up) {
+				i += 3;
+				continue;
+			}
+
+			out[w++] = '/';
+			break;
+		}
+
+		/* D. A lone "." or ".." */
+		if (dot_rest(in, n, i, ".", 1) || dot_rest(in, n, i, "..", 2))
+			break;
+
+		/* E. The first segment, with its '/' (slash) */
+		size_t start = i;
+
+		if (in[i] == '/')
+			++i;
+		while (i < n && in[i] != '/')
+			++i;
+
+		std::memmove(out + w, in + start, i - start);
+		w += i - start;
+	}
+
+	return w;
+}
+
+/* userinfo "@" host ":" port, as written */
+inline text_view authority(const view &v) {
+	size_t b = v.has(USERINFO) ? v.begin(USERINFO) : v.begin(HOST);
+	size_t e = v.has(PORT) ? v.end(PORT) : v.end(HOST);
+	return text_view(v.value().data() + b, e - b);
+}
+
+} //namespace details
+/// @endcond
+
+/**
+ * @class resolver
+ * @brief Resolves references against a base URL
+ *
+ * The base is parsed once and kept, to resolve many references, as the links
+ * of a page. References are parsed with url::view, relative or not. The
+ * result is written into a caller string, which is reused: once it has grown
+ * enough, resolving allocates nothing.
+ *
+ *	cm::url::resolver page("http://example.com/a/b.html");
+ *	std::string out;
+ *	page.resolve("../c.html?x=1", out);   // http://example.com/c.html?x=1
+ *
+ * The result is not normalized, see url::normalize().
+ *
+ * Does not throw any exception in case of invalid input.
+ * Caller must check the resolver::has_error() or the resolve() result.
+ */
+class resolver : public error_check {
+
+	public:
+
+		/// A resolver without a base, every resolution fails
+		resolver() { set_error("Missing base URL"); }
+
+		/**
+		 * @brief Creates a resolver
+		 *
+		 * @param base The base URL, copied
+		 * @param n    The size
+		 */
+		resolver(const char *base, size_t n) { rebase(base, n); }
+
+		/// Convenience constructor
+		resolver(const std::string &base) { rebase(base.data(), base.size()); }
+
+		resolver(const resolver &) = delete;
+		resolver & operator=(const resolver &) = delete;
+
+		/**
+		 * @brief Replaces the base URL
+		 *
+		 * @param base The base URL, an absolute URL, copied
+		 * @param n    The size
+		 *
+		 * @return false if the base is not a valid absolute URL.
+		 */
+		bool rebase(const char *base, size_t n) {
+
+			_text.assign(base, n);
+			_valid = false;
+
+			if (! _base.parse(_text.data(), _text.size())) {
+				set_error("Invalid base URL: " + _base.error());
+				return false;
+			}
+
+			if (! _base.is_absolute()) {
+				set_error("Base URL is not absolute");
+				return false;
+			}
+
+			/* The path up to and with its last '/' (slash), for merging */
+			text_view path = _base.get(PATH);
+			_dir = path.size();
+			while (_dir > 0 && path.data()[_dir - 1] != '/')
+				--_dir;
+
+			_err.clear();
+			_valid = true;
+
+			return true;
+		}
+
+		/**
+		 * @brief Resolves a parsed reference
+		 *
+		 * @param r   The reference
+		 * @param out The target URL, empty on error. Reusing it avoids allocations.
+		 *
+		 * @return false if the base or the reference has an error.
+		 */
+		bool resolve(const view &r, std::string &out) {
+
+			out.clear();
+
+			if (! _valid)
+				return false;
+
+			if (r.has_error()) {
+				set_error(r.error());
+				return false;
+			}
+
+			_err.clear();
+
+			const view &b = _base;
+
+			append(out, r.is_absolute() ? r.get(SCHEME) : b.get(SCHEME));
+			out += ':';
+
+			if (r.is_absolute() || r.has_authority()) {
+
+				if (r.has_authority()) {
+					out += "//";
+					append(out, details::authority(r));
+				}
+
+				append_path(out, r.get(PATH), text_view());
+
+			} else {
+
+				if (b.has_authority()) {
+					out += "//";
+					append(out, details::authority(b));
+				}
+
+				text_view path = r.get(PATH);
+
+				if (path.empty()) {
+
+					append(out, b.get(PATH));
+
+					if (! r.has(QUERY) && b.has(QUERY)) {
+						out += '?';
+						append(out, b.get(QUERY));
+					}
+
+				} else if (path.data()[0] == '/') {
+					append_path(out, path, text_view());
+				} else if (b.has_authority() && b.get(PATH).empty()) {
+					append_path(out, path, text_view("/", 1));
+				} else {
+					append_path(out, path, text_view(b.get(PATH).data(), _dir));
+				}
+			}
+
+			if (r.has(QUERY)) {
+				out += '?';
+				append(out, r.get(QUERY));
+			}
+
+			if (r.has(FRAGMENT)) {
+				out += '#';
+				append(out, r.get(FRAGMENT));
+			}
+
+			return true;
+		}
+
+		/**
+		 * @brief Resolves a reference
+		 *
+		 * @param ref The reference
+		 * @param n   The size
+		 * @param out The target URL, empty on error. Reusing it avoids allocations.
+		 *
+		 * @return false if the base or the reference has an error.
+		 */
+		bool resolve(const char *ref, size_t n, std::string &out) {
+			_ref.parse(ref, n);
+			return resolve(_ref, out);
+		}
+
+		/// Convenience overload
+		inline bool resolve(const std::string &ref, std::string &out) {
+			return resolve(ref.data(), ref.size(), out);
+		}
+
+		/// The parsed base URL
+		inline const view & base() const { return _base; }
+
+	private:
+
+		static inline void append(std::string &out, const text_view &t) {
+			out.append(t.data(), t.size());
+		}
+
+		/* Merges a path with a directory and removes its dot segments, in place */
+		static void append_path(std::string &out, const text_view &path, const text_view &dir) {
+
+			size_t start = out.size();
+
+			append(out, dir);
+			append(out, path);
+
+			char *p = &out[0] + start;
+			out.resize(start + details::remove_dot_segments(p, out.size() - start, p));
+		}
+
+		std::string _text;
+		view        _base;
+		view        _ref;
+		size_t      _dir = 0;
+		bool        _valid = false;
+
+};
+
+}//namespace url
+}//namespace cm
+
+#endif //_CM_URL_RESOLVE_
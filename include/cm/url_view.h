@@ -0,0 +1,370 @@
+#ifndef _CM_URL_VIEW_
+#define _CM_URL_VIEW_
+
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/text_view.h>
+#include <cm/net.h>
+#include <cm/url.h>
+
+/*
+
+	URI reference - http://tools.ietf.org/html/rfc3986#section-4.1
+
+	URI-reference = URI / relative-ref
+	URI           = scheme ":" hier-part [ "?" query ] [ "#" fragment ]
+	relative-ref  = relative-part [ "?" query ] [ "#" fragment ]
+	hier-part     = "//" authority path-abempty / path-absolute / path-rootless / path-empty
+	authority     = [ userinfo "@" ] host [ ":" port ]
+	host          = IP-literal / IPv4address / reg-name
+
+	Regular expression for breaking-down a URI reference - http://tools.ietf.org/html/rfc3986#appendix-B
+
+	^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\?([^#]*))?(#(.*))?
+
+*/
+
+namespace cm {
+namespace url {
+
+/// A range of characters of a URL
+typedef cm::text_view text_view;
+
+/// The components of a URL
+enum component {
+	SCHEME = 0,
+	USERINFO,
+	HOST,
+	PORT,
+	PATH,
+	QUERY,
+	FRAGMENT,
+	COMPONENTS
+};
+
+/**
+ * @class view
+ * @brief One pass URL parser, keeping the component offsets over the input
+ *
+ * Parses an absolute URL or a relative reference with the RFC 3986 syntax, in a
+ * single scan and without allocating on success. The components are ranges of
+ * the input, which the caller keeps while using them. Delimiters are not part
+ * of the components: the scheme has no ':', the query no '?'.
+ *
+ * A component may be absent or present and empty: "http://host?" has an empty
+ * query, "http://host" has none. The path is always present, maybe empty.
+ *
+ *	cm::url::view u("https://john@example.com:8042/over/there?name=ferret#nose");
+ *	u.get(cm::url::HOST);   // example.com
+ *	u.port_number();        // 8042
+ *
+ * Does not throw any exception in case of invalid input.
+ * Caller must check the view::has_error().
+ */
+class view : public error_check {
+
+	public:
+
+		/// An empty view
+		view() {}
+
+		/**
+		 * @brief Parses a URL
+		 *
+		 * @param in The URL, kept by the caller
+		 * @param n  The size
+		 */
+		view(const char *in, size_t n) { parse(in, n); }
+
+		/// Convenience constructor, the C string is kept by the caller
+		view(const char *in) { parse(in, std::strlen(in)); }
+
+		/// Convenience constructor, the string is kept by the caller
+		view(const std::string &in) { parse(in.data(), in.size()); }
+
+		/// A temporary string would not outlive the view
+		view(std::string &&) = delete;
+
+		/**
+		 * @brief Parses a URL, replacing the previous one
+		 *
+		 * @param in The URL, kept by the caller
+		 * @param n  The size
+		 *
+		 * @return false if the URL has an error.
+		 */
+		bool parse(const char *in, size_t n) {
+
+			_err.clear();
+			_p = in;
+			_n = static_cast<uint32_t>(n);
+			_present = 0;
+			_port = 0;
+			std::memset(_begin, 0, sizeof(_begin));
+			std::memset(_end, 0, sizeof(_end));
+
+			if (n > UINT32_MAX)
+				return fail(0, "URL too big");
+
+			size_t i = 0;
+
+			/* scheme = ALPHA *( ALPHA / DIGIT / "+" / "-" / "." ) */
+			if (n && ( details::char_bits(in[0]) & details::CC_ALPHA )) {
+
+				size_t j = 1;
+				while (j < n && is_scheme_char(in[j]))
+					++j;
+
+				if (j < n && in[j] == ':') {
+					set(SCHEME, 0, j);
+					i = j + 1;
+				}
+			}
+
+			/* "//" authority */
+			if (i + 1 < n && in[i] == '/' && in[i + 1] == '/') {
+
+				i += 2;
+
+				size_t end = i;
+				size_t at = n;
+
+				for (; end < n && in[end] != '/' && in[end] != '?' && in[end] != '#'; ++end)
+					if (in[end] == '@' && at == n)
+						at = end;
+
+				size_t host = i;
+
+				if (at != n) {
+
+					/* userinfo = *( unreserved / pct-encoded / sub-delims / ":" ) */
+					size_t stop = scan(in, i, at, details::CC_UNRESERVED | details::CC_SUB_DELIMS, ':');
+
+					if (has_error())
+						return false;
+
+					if (stop != at)
+						return fail(stop, "Invalid character in userinfo");
+
+					set(USERINFO, i, at);
+					host = at + 1;
+				}
+
+				if (! parse_host(in, host, end))
+					return false;
+
+				i = end;
+			}
+
+			/* path, up to the query or the fragment */
+			size_t stop = scan(in, i, n, PCHAR | details::CC_SLASH);
+
+			if (has_error())
+				return false;
+
+			if (stop < n && in[stop] != '?' && in[stop] != '#')
+				return fail(stop, "Invalid character in path");
+
+			/* path-noscheme: "a:b" would be a scheme */
+			if (! has(SCHEME) && ! has(HOST)) {
+				const char *colon = static_cast<const char *>(std::memchr(in + i, ':', stop - i));
+				const char *slash = static_cast<const char *>(std::memchr(in + i, '/', stop - i));
+				if (colon && ( ! slash || colon < slash ))
+					return fail(static_cast<size_t>(colon - in), "Colon in the first segment of a relative path");
+			}
+
+			set(PATH, i, stop);
+			i = stop;
+
+			/* "?" query */
+			if (i < n && in[i] == '?') {
+
+				stop = scan(in, i + 1, n, PCHAR | details::CC_SLASH | details::CC_QUESTION);
+
+				if (has_error())
+					return false;
+
+				if (stop < n && in[stop] != '#')
+					return fail(stop, "Invalid character in query");
+
+				set(QUERY, i + 1, stop);
+				i = stop;
+			}
+
+			/* "#" fragment */
+			if (i < n && in[i] == '#') {
+
+				stop = scan(in, i + 1, n, PCHAR | details::CC_SLASH | details::CC_QUESTION);
+
+				if (has_error())
+					return false;
+
+				if (stop < n)
+					return fail(stop, "Invalid character in fragment");
+
+				set(FRAGMENT, i + 1, stop);
+			}
+
+			return true;
+		}
+
+		/// Checks if a component is present, maybe empty
+		inline bool has(component c) const { return _present & ( 1u << c ); }
+
+		/// Gets a component, empty if absent
+		inline text_view get(component c) const { return text_view(_p + _begin[c], _end[c] - _begin[c]); }
+
+		/// The offset of a component first character
+		inline size_t begin(component c) const { return _begin[c]; }
+
+		/// The offset after a component last character
+		inline size_t end(component c) const { return _end[c]; }
+
+		/// Checks if it has a scheme, otherwise it is a relative reference
+		inline bool is_absolute() const { return has(SCHEME); }
+
+		/// Checks if it has an authority, the "//" part
+		inline bool has_authority() const { return has(HOST); }
+
+		/// The port value, 0 if absent or empty
+		inline uint16_t port_number() const { return _port; }
+
+		/// The whole input
+		inline text_view value() const { return text_view(_p, _n); }
+
+	private:
+
+		static constexpr unsigned char PCHAR = details::CC_UNRESERVED | details::CC_SUB_DELIMS | details::CC_PCHAR;
+
+		static inline bool is_scheme_char(char c) {
+			return ( details::char_bits(c) & ( details::CC_ALPHA | details::CC_DIGIT ) ) || c == '+' || c == '-' || c == '.';
+		}
+
+		inline void set(component c, size_t b, size_t e) {
+			_begin[c] = static_cast<uint32_t>(b);
+			_end[c] = static_cast<uint32_t>(e);
+			_present |= static_cast<uint8_t>(1u << c);
+		}
+
+		bool fail(size_t pos, const char *err) {
+			std::stringstream ss;
+			ss << err << " [pos: " << pos << "]";
+			set_error(ss.str());
+			_present = 0;
+			return false;
+		}
+
+		/*
+		 * Skips the characters of a class, percent-encodings and an extra character.
+		 * Returns the first other position; sets the error on a bad percent-encoding.
+		 */
+		size_t scan(const char *in, size_t i, size_t n, unsigned char mask, char extra = '\0') {
+
+			i += percent::scan(in + i, n - i, mask, extra);
+
+			if (i < n && in[i] == '%')
+				fail(i, "Bad percent-encoding");
+
+			return i;
+		}
+
+		/* host [ ":" port ], up to the end of the authority */
+		bool parse_host(const char *in, size_t i, size_t end) {
+
+			size_t stop;
+
+			if (i < end && in[i] == '[') {
+
+				/* IP-literal = "[" ( IPv6address / IPvFuture ) "]" */
+				const char *close = static_cast<const char *>(std::memchr(in + i, ']', end - i));
+
+				if (! close)
+					return fail(i, "Unfinished IP literal host");
+
+				stop = static_cast<size_t>(close - in) + 1;
+
+				if (stop == i + 2)
+					return fail(i, "Empty IP literal host");
+
+				if (in[i + 1] == 'v' || in[i + 1] == 'V') {
+
+					/* IPvFuture = "v" 1*HEXDIG "." 1*( unreserved / sub-delims / ":" ) */
+					size_t k = i + 2;
+
+					while (k < stop - 1 && ( details::char_bits(in[k]) & details::CC_HEX ))
+						++k;
+
+					if (k == i + 2 || k == stop - 1 || in[k] != '.')
+						return fail(k, "Invalid IP literal version");
+
+					if (++k == stop - 1)
+						return fail(k, "Empty IP literal address");
+
+					for (; k < stop - 1; ++k)
+						if (! ( details::char_bits(in[k]) & ( details::CC_UNRESERVED | details::CC_SUB_DELIMS ) ) && in[k] != ':')
+							return fail(k, "Invalid character in IP literal host");
+
+				} else {
+
+					/* Not net::ip_literal_facade, which also takes an IPv4 address */
+					error_check addr;
+					net::ipv6::check(in + i + 1, stop - i - 2, addr);
+
+					if (addr.has_error())
+						return fail(i + 1, "Invalid IPv6 literal host");
+				}
+
+			} else {
+
+				/* reg-name = *( unreserved / pct-encoded / sub-delims ) */
+				stop = scan(in, i, end, details::CC_UNRESERVED | details::CC_SUB_DELIMS);
+
+				if (has_error())
+					return false;
+			}
+
+			set(HOST, i, stop);
+
+			if (stop == end)
+				return true;
+
+			if (in[stop] != ':')
+				return fail(stop, "Invalid character in host");
+
+			/* port = *DIGIT */
+			uint32_t port = 0;
+
+			for (size_t k = stop + 1; k < end; ++k) {
+
+				if (! ( details::char_bits(in[k]) & details::CC_DIGIT ))
+					return fail(k, "Invalid character in port");
+
+				port = port * 10 + static_cast<uint32_t>(in[k] - '0');
+
+				if (port > 65535)
+					return fail(stop + 1, "Port number too big");
+			}
+
+			set(PORT, stop + 1, end);
+			_port = static_cast<uint16_t>(port);
+
+			return true;
+		}
+
+		const char * _p = nullptr;
+		uint32_t     _n = 0;
+		uint32_t     _begin[COMPONENTS] = {};
+		uint32_t     _end[COMPONENTS] = {};
+		uint16_t     _port = 0;
+		uint8_t      _present = 0;
+
+};
+
+}//namespace url
+}//namespace cm
+
+#endif //_CM_URL_VIEW_
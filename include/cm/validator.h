@@ -118,18 +118,17 @@ class range : public std::initializer_list<char> {
 		inline size_type get_count() const    { return _count; }
 		inline size_type get_offset() const   { return _offset; }
 
+		/* Iterators of the referenced string, not of a copy of it */
 		iterator begin() const            {
-			iterator it = std::remove_const<value_type>::type(_value).begin();
+			iterator it = const_cast<value_type &>(_value).begin();
 			std::advance(it, _offset);
 			return it;
-			//return std::remove_const<value_type>::type(_value).begin();
 		}
 		iterator end() const              {
 
-			iterator it = std::remove_const<value_type>::type(_value).begin();
+			iterator it = const_cast<value_type &>(_value).begin();
 			std::advance(it, _offset + _count);
 			return it;
-			//return std::remove_const<value_type>::type(_value).end();
 		}
 
 		const_reference front() const {
@@ -295,6 +294,12 @@ struct no_count {
 		void incr_bad() {};
 };
 
+struct no_track {
+	protected:
+		template <class V>
+		void track(const V &) {}
+};
+
 ///@endcond
 
 
@@ -312,10 +317,11 @@ struct no_count {
 
  E - Exception type to throw
  * do_count - Boolean: enables counting good/bad validator feature
+ * tracker - Policy: sees every good object (e.g. cm::tracking in cm/sketch.h)
  *
  */
-template <class T, class E = std::invalid_argument, bool do_count = false >
-class validator : public std::conditional<do_count, count, no_count >::type {
+template <class T, class E = std::invalid_argument, bool do_count = false, class tracker = no_track >
+class validator : public std::conditional<do_count, count, no_count >::type, public tracker {
 
 	static_assert(std::is_base_of<error_check, T>::value, "T must be a descendant of error_check");
 
@@ -356,6 +362,7 @@ class validator : public std::conditional<do_count, count, no_count >::type {
 		}
 
 		count_type::incr_good();
+		tracker::track(val);
 
 		return val;
 	}
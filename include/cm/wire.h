@@ -0,0 +1,244 @@
+#ifndef _CM_WIRE_
+#define _CM_WIRE_
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/domain.h>
+
+/*
+
+	Domain names in messages - http://tools.ietf.org/html/rfc1035#section-3.1
+
+	Domain names in messages are expressed in terms of a sequence of labels.
+	Each label is represented as a one octet length field followed by that
+	number of octets. Since every domain name ends with the null label of
+	the root, a domain name is terminated by a length byte of zero.
+
+	www.Example.com  =>  \003www\007example\003com\000
+
+	Canonical DNS name order - http://tools.ietf.org/html/rfc4034#section-6.1
+
+	Names are sorted by their most significant (rightmost) labels first. Labels
+	are compared as left-justified unsigned octet sequences, with uppercase
+	US-ASCII letters treated as lowercase. A missing octet sorts before a zero
+	octet, so "example" < "a.example" < "z.example".
+
+*/
+
+namespace cm {
+namespace dns {
+
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+/// Maximum number of labels in a wire name, including the root
+constexpr static size_t max_wire_labels = 128;
+
+inline unsigned char wire_lower(unsigned char c) {
+	return ( c >= 'A' && c <= 'Z' ) ? static_cast<unsigned char>(c + 32) : c;
+}
+
+/**
+ * @brief Finds the offset of each label length byte of a wire name
+ *
+ * @return The number of labels before the root, or -1 if not well formed.
+ */
+inline int wire_labels(const unsigned char *wire, size_t n, size_t *offsets) {
+
+	int count = 0;
+
+	for (size_t pos = 0; pos < n; ) {
+
+		unsigned char len = wire[pos];
+
+		if (len == 0)
+			return count;
+
+		if (len > domain::max_label_size || count >= static_cast<int>(max_wire_labels))
+			return -1;
+
+		offsets[count++] = pos;
+		pos += len + 1;
+	}
+
+	return -1;
+}
+
+} //namespace details
+/// @endcond
+
+/// Maximum size of a name in wire format - RFC 1035
+constexpr static size_t max_wire_size = 255;
+
+/**
+ * @brief Converts a domain name to the lowercase wire format
+ *
+ * @param d    The valid domain name. IP literals have no wire format.
+ * @param buf  The caller buffer
+ * @param size The caller buffer size
+ * @param len  The number of bytes written, including the root label
+ *
+ * @return false if the domain has an error, is a literal or does not fit.
+ */
+inline bool to_wire(const domain &d, unsigned char *buf, size_t size, size_t &len) {
+
+	if (d.has_error())
+		return false;
+
+	const std::string &in = d.value();
+
+	if (in.empty() || in.front() == '[')
+		return false;
+
+	/* One length byte per label plus the root label */
+	len = in.size() + 2;
+	if (len > max_wire_size || len > size)
+		return false;
+
+	size_t label = 0;
+
+	for (size_t i = 0; i < in.size(); ++i) {
+
+		unsigned char c = static_cast<unsigned char>(in[i]);
+
+		if (c == '.') {
+			buf[label] = static_cast<unsigned char>(i - label);
+			label = i + 1;
+			continue;
+		}
+
+		buf[i + 1] = details::wire_lower(c);
+	}
+
+	if (in.size() - label > domain::max_label_size)
+		return false;
+
+	buf[label] = static_cast<unsigned char>(in.size() - label);
+	buf[in.size() + 1] = 0;
+
+	return true;
+}
+
+/**
+ * @brief Converts a domain name to a wire format key
+ *
+ * The key is compact and needs no further case folding: equal names give equal keys.
+ *
+ * @return The key, or an empty string if the name cannot be converted.
+ */
+inline std::string wire_key(const domain &d) {
+
+	unsigned char buf[max_wire_size];
+	size_t len = 0;
+
+	if (! to_wire(d, buf, sizeof(buf), len))
+		return std::string();
+
+	return std::string(reinterpret_cast<const char *>(buf), len);
+}
+
+/**
+ * @brief Converts a name in wire format back to text
+ *
+ * Compression pointers are not followed. Each label is checked with the domain rules.
+ * The text has no trailing dot; the root name has no text at all.
+ *
+ * @param wire The wire name
+ * @param n    The wire name size
+ * @param out  The caller buffer
+ * @param size The caller buffer size
+ * @param len  The number of characters written
+ *
+ * @return false if the wire name is not well formed, has an invalid label or does not fit.
+ */
+inline bool from_wire(const unsigned char *wire, size_t n, char *out, size_t size, size_t &len) {
+
+	len = 0;
+
+	for (size_t pos = 0; pos < n && pos < max_wire_size; ) {
+
+		unsigned char l = wire[pos++];
+
+		if (l == 0)
+			return true;
+
+		if (l > domain::max_label_size || pos + l > n)
+			return false;
+
+		if (! domain::is_valid_label(reinterpret_cast<const char *>(wire + pos), l))
+			return false;
+
+		if (len + l + (len ? 1 : 0) > size)
+			return false;
+
+		if (len)
+			out[len++] = '.';
+
+		std::memcpy(out + len, wire + pos, l);
+		len += l;
+		pos += l;
+	}
+
+	return false;
+}
+
+/**
+ * @brief Compares two well formed wire names in the canonical DNS order
+ *
+ * @return A negative value, zero or a positive value if a sorts before, equal or after b.
+ */
+inline int canonical_compare(const unsigned char *a, size_t an, const unsigned char *b, size_t bn) {
+
+	size_t la[details::max_wire_labels];
+	size_t lb[details::max_wire_labels];
+
+	int na = details::wire_labels(a, an, la);
+	int nb = details::wire_labels(b, bn, lb);
+
+	/* Malformed names sort first */
+	if (na < 0 || nb < 0)
+		return ( na < 0 ? -1 : 0 ) - ( nb < 0 ? -1 : 0 );
+
+	while (na > 0 && nb > 0) {
+
+		const unsigned char *pa = a + la[--na];
+		const unsigned char *pb = b + lb[--nb];
+
+		size_t sa = *pa++;
+		size_t sb = *pb++;
+		size_t common = ( sa < sb ? sa : sb );
+
+		for (size_t i = 0; i < common; ++i) {
+			int d = static_cast<int>(details::wire_lower(pa[i])) - details::wire_lower(pb[i]);
+			if (d)
+				return d;
+		}
+
+		if (sa != sb)
+			return ( sa < sb ? -1 : 1 );
+	}
+
+	return na - nb;
+}
+
+/**
+ * @class canonical_less
+ * @brief Strict weak ordering of wire format keys in the canonical DNS order
+ *
+ * std::set<std::string, cm::dns::canonical_less> keeps zone data sorted without a text round trip.
+ */
+struct canonical_less {
+
+	inline bool operator()(const std::string &a, const std::string &b) const {
+		return canonical_compare(
+				reinterpret_cast<const unsigned char *>(a.data()), a.size(),
+				reinterpret_cast<const unsigned char *>(b.data()), b.size()) < 0;
+	}
+};
+
+}//namespace dns
+}//namespace cm
+
+#endif //_CM_WIRE_
@@ -0,0 +1,1060 @@
+#ifndef _CM_ZONE_
+#define _CM_ZONE_
+
+#include <string>
+#include <stdexcept>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <cstring>
+#include <cstdint>
+
+#include <cm/validator.h>
+#include <cm/ascii.h>
+#include <cm/mapped_file.h>
+#include <cm/domain.h>
+#include <cm/net.h>
+
+/*
+
+	DNS master files - http://tools.ietf.org/html/rfc1035#section-5
+
+	<blank>[<comment>]
+	$ORIGIN <domain-name> [<comment>]
+	$TTL <ttl> [<comment>]                       (RFC 2308)
+	<domain-name><rr> [<comment>]
+	<blank><rr> [<comment>]
+
+	<rr> contents take one of the following forms:
+
+	[<TTL>] [<class>] <type> <RDATA>
+	[<class>] [<TTL>] <type> <RDATA>
+
+	Parentheses continue a record over line boundaries, semicolons start comments
+	and double quotes delimit character strings.
+
+	Names may use the \X and \DDD escapes. The $INCLUDE directive is not
+	supported and is reported as an error.
+
+*/
+
+namespace cm {
+namespace dns {
+
+namespace exceptions {
+
+/**
+ * @class invalid_zone
+ * @brief An exception class to indicate that a zone file has an invalid syntax.
+ */
+class invalid_zone : public std::invalid_argument {
+	// C++11 inheriting constructors
+	using invalid_argument::invalid_argument;
+};
+
+} //namespace exceptions
+
+/// @cond INTERNAL_DETAIL
+namespace details {
+
+/* A view over the zone file buffer */
+struct zone_token {
+	const char * p;
+	size_t       n;
+};
+
+inline bool token_iequals(const zone_token &t, const char *s) {
+
+	size_t i = 0;
+	for (; i < t.n && s[i]; ++i)
+		if (ascii::lower(t.p[i]) != ascii::lower(s[i]))
+			return false;
+
+	return ( i == t.n && s[i] == '\0' );
+}
+
+/* Mnemonic followed by digits: TYPE65534, CLASS255 */
+inline bool token_generic(const zone_token &t, const char *prefix) {
+
+	size_t len = std::strlen(prefix);
+	if (t.n <= len)
+		return false;
+
+	if (! token_iequals(zone_token{ t.p, len }, prefix))
+		return false;
+
+	for (size_t i = len; i < t.n; ++i)
+		if (! ::isdigit(static_cast<unsigned char>(t.p[i])))
+			return false;
+
+	return true;
+}
+
+constexpr static const char * zone_types_names[] = {
+	"A", "NS", "MD", "MF", "CNAME", "SOA", "MB", "MG", "MR", "NULL", "WKS", "PTR",
+	"HINFO", "MINFO", "MX", "TXT", "RP", "AFSDB", "X25", "ISDN", "RT", "NSAP",
+	"SIG", "KEY", "PX", "GPOS", "AAAA", "LOC", "NXT", "SRV", "NAPTR", "KX", "CERT",
+	"DNAME", "APL", "DS", "SSHFP", "IPSECKEY", "RRSIG", "NSEC", "DNSKEY", "DHCID",
+	"NSEC3", "NSEC3PARAM", "TLSA", "SMIMEA", "HIP", "CDS", "CDNSKEY", "OPENPGPKEY",
+	"CSYNC", "ZONEMD", "SVCB", "HTTPS", "SPF", "NID", "L32", "L64", "LP", "EUI48",
+	"EUI64", "URI", "CAA", "AVC", "DLV",
+	nullptr
+};
+
+inline bool is_zone_type(const zone_token &t) {
+
+	for (size_t i = 0; zone_types_names[i]; ++i)
+		if (token_iequals(t, zone_types_names[i]))
+			return true;
+
+	return token_generic(t, "TYPE");
+}
+
+inline bool is_zone_class(const zone_token &t) {
+	return ( token_iequals(t, "IN") || token_iequals(t, "CH") || token_iequals(t, "HS") ||
+			token_iequals(t, "CS") || token_generic(t, "CLASS") );
+}
+
+/* Unsigned decimal up to max */
+inline bool parse_number(const zone_token &t, uint64_t max, uint64_t &value) {
+
+	if (t.n == 0 || t.n > 10)
+		return false;
+
+	value = 0;
+	for (size_t i = 0; i < t.n; ++i) {
+		if (! ::isdigit(static_cast<unsigned char>(t.p[i])))
+			return false;
+		value = value * 10 + (t.p[i] - '0');
+	}
+
+	return value <= max;
+}
+
+/* TTL as seconds or with BIND units: 1w2d3h4m5s */
+inline bool parse_ttl(const zone_token &t, uint32_t &ttl) {
+
+	constexpr uint64_t max_ttl = 0x7FFFFFFF; // RFC 2181 section 8
+
+	if (t.n == 0 || ! ::isdigit(static_cast<unsigned char>(t.p[0])))
+		return false;
+
+	uint64_t total = 0;
+	uint64_t current = 0;
+	bool digits = false;
+
+	for (size_t i = 0; i < t.n; ++i) {
+
+		char c = ascii::lower(t.p[i]);
+
+		if (c >= '0' && c <= '9') {
+			current = current * 10 + (c - '0');
+			digits = true;
+			if (current > max_ttl)
+				return false;
+			continue;
+		}
+
+		if (! digits)
+			return false;
+
+		uint64_t unit = 0;
+		switch (c) {
+			case 's': unit = 1;      break;
+			case 'm': unit = 60;     break;
+			case 'h': unit = 3600;   break;
+			case 'd': unit = 86400;  break;
+			case 'w': unit = 604800; break;
+			default: return false;
+		}
+
+		total += current * unit;
+		current = 0;
+		digits = false;
+
+		if (total > max_ttl)
+			return false;
+	}
+
+	total += current;
+	if (total > max_ttl)
+		return false;
+
+	ttl = static_cast<uint32_t>(total);
+	return true;
+}
+
+/* The parsing context that carries over records */
+struct zone_state {
+	std::string origin;             // without the trailing dot, empty for the root
+	bool        has_origin = false;
+	std::string owner;              // last owner name
+	bool        has_owner  = false;
+	uint32_t    ttl        = 0;     // $TTL
+};
+
+/* The directives in effect are the same */
+inline bool same_directives(const zone_state &a, const zone_state &b) {
+	return a.has_origin == b.has_origin && a.origin == b.origin && a.ttl == b.ttl;
+}
+
+struct zone_error {
+	size_t      offset;
+	std::string message;
+};
+
+/**
+ * @brief Parses the records of a zone file region sequentially
+ */
+class zone_reader {
+
+	public:
+
+		zone_reader(const char *buf, size_t size, size_t max_errors) :
+			_buf(buf), _size(size), _max_errors(max_errors) { }
+
+		/**
+		 * @brief Parses all records starting from start and before limit
+		 *
+		 * A record starting before the limit is parsed until its end, even past the limit.
+		 *
+		 * @return The start of the next record, i.e. where parsing stopped.
+		 */
+		size_t parse(size_t start, size_t limit) {
+
+			size_t pos = next_record(start);
+
+			while (pos < limit && pos < _size) {
+
+				size_t end = pos;
+				bool has_owner = ! is_blank(_buf[pos]) && _buf[pos] != '(';
+
+				if (tokenize(pos, end) && ! _tokens.empty()) {
+					if (has_owner && _buf[pos] == '$')
+						directive(pos);
+					else
+						record(pos, has_owner);
+				}
+
+				pos = next_record(end);
+			}
+
+			return pos;
+		}
+
+		/**
+		 * @brief Applies a directive line without reporting errors
+		 */
+		void apply_directive(size_t pos) {
+			size_t end = pos;
+			size_t errors = _errors.size();
+			size_t count = _error_count;
+
+			if (tokenize(pos, end) && ! _tokens.empty())
+				directive(pos);
+
+			_errors.resize(errors);
+			_error_count = count;
+		}
+
+		/* Skips blank lines and comment lines */
+		size_t next_record(size_t pos) const {
+
+			while (pos < _size) {
+
+				size_t p = pos;
+				while (p < _size && (is_blank(_buf[p]) || _buf[p] == '\r'))
+					++p;
+
+				if (p >= _size)
+					return _size;
+
+				if (_buf[p] == '\n') {
+					pos = p + 1;
+					continue;
+				}
+
+				if (_buf[p] == ';') {
+					const char *nl = static_cast<const char *>(std::memchr(_buf + p, '\n', _size - p));
+					if (! nl)
+						return _size;
+					pos = (nl - _buf) + 1;
+					continue;
+				}
+
+				return pos;
+			}
+
+			return _size;
+		}
+
+		zone_state                    state;
+
+		inline size_t records() const { return _records; }
+		inline size_t error_count() const { return _error_count; }
+		inline std::vector<zone_error> & errors() { return _errors; }
+
+	private:
+
+		static bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+		void error(size_t offset, const std::string &msg) {
+
+			++_error_count;
+
+			if (_errors.size() < _max_errors)
+				_errors.push_back(zone_error{ offset, msg });
+		}
+
+		/* Skips the rest of the line after a syntax error */
+		size_t skip_line(size_t p) const {
+			const char *nl = static_cast<const char *>(std::memchr(_buf + p, '\n', _size - p));
+			return ( nl ? static_cast<size_t>(nl - _buf) + 1 : _size );
+		}
+
+		/**
+		 * @brief Splits a record into tokens, across lines when inside parentheses
+		 */
+		bool tokenize(size_t start, size_t &end) {
+
+			_tokens.clear();
+
+			unsigned depth = 0;
+			size_t p = start;
+			size_t open = start;
+
+			while (p < _size) {
+
+				char c = _buf[p];
+
+				if (is_blank(c) || c == '\r') {
+					++p;
+					continue;
+				}
+
+				if (c == '\n') {
+					if (depth == 0) {
+						end = p + 1;
+						return true;
+					}
+					++p;
+					continue;
+				}
+
+				if (c == ';') {
+					const char *nl = static_cast<const char *>(std::memchr(_buf + p, '\n', _size - p));
+					p = ( nl ? static_cast<size_t>(nl - _buf) : _size );
+					continue;
+				}
+
+				if (c == '(') {
+					if (depth == 0)
+						open = p;
+					++depth;
+					++p;
+					continue;
+				}
+
+				if (c == ')') {
+					if (depth == 0) {
+						error(p, "Unbalanced ')' (closing parenthesis).");
+						end = skip_line(p);
+						return false;
+					}
+					--depth;
+					++p;
+					continue;
+				}
+
+				if (c == '"') {
+
+					size_t q = p + 1;
+					while (q < _size && _buf[q] != '"' && _buf[q] != '\n') {
+						if (_buf[q] == '\\')
+							++q;
+						++q;
+					}
+
+					if (q >= _size || _buf[q] != '"') {
+						error(p, "Unterminated quoted string.");
+						end = skip_line(p);
+						return false;
+					}
+
+					_tokens.push_back(zone_token{ _buf + p + 1, q - p - 1 });
+					p = q + 1;
+					continue;
+				}
+
+				size_t q = p;
+				while (q < _size) {
+					char d = _buf[q];
+					if (is_blank(d) || d == '\r' || d == '\n' || d == ';' ||
+							d == '(' || d == ')' || d == '"')
+						break;
+					if (d == '\\' && q + 1 < _size)
+						++q;
+					++q;
+				}
+
+				_tokens.push_back(zone_token{ _buf + p, q - p });
+				p = q;
+			}
+
+			if (depth > 0) {
+				error(open, "Unbalanced '(' (opening parenthesis) at end of file.");
+				end = _size;
+				return false;
+			}
+
+			end = _size;
+			return true;
+		}
+
+		/**
+		 * @brief Makes a name absolute using the current origin
+		 */
+		bool resolve(const zone_token &t, std::string &out, std::string &msg) const {
+
+			if (t.n == 1 && t.p[0] == '@') {
+				if (! state.has_origin) {
+					msg = "The '@' (at-sign) name used without $ORIGIN.";
+					return false;
+				}
+				out = state.origin;
+				return true;
+			}
+
+			/* Absolute name, unless an odd number of backslashes escape the last dot */
+			size_t slashes = 0;
+			while (slashes + 1 < t.n && t.p[t.n - 2 - slashes] == '\\')
+				++slashes;
+
+			if (t.n > 0 && t.p[t.n - 1] == '.' && slashes % 2 == 0) {
+				out.assign(t.p, t.n - 1);
+				return true;
+			}
+
+			if (! state.has_origin) {
+				msg = "Relative name used without $ORIGIN.";
+				return false;
+			}
+
+			out.assign(t.p, t.n);
+			if (! state.origin.empty()) {
+				out.push_back('.');
+				out.append(state.origin);
+			}
+
+			return true;
+		}
+
+		/* Finds the end of the label at i, counting its octets: \X and \DDD are one each */
+		static bool label_end(const std::string &name, size_t &i, size_t &octets) {
+
+			octets = 0;
+
+			for (; i < name.size() && name[i] != '.'; ++octets) {
+
+				if (name[i] != '\\') {
+					++i;
+					continue;
+				}
+
+				if (i + 1 >= name.size())
+					return false;
+
+				if (! ::isdigit(static_cast<unsigned char>(name[i + 1]))) {
+					i += 2;
+					continue;
+				}
+
+				if (i + 3 >= name.size() ||
+						! ::isdigit(static_cast<unsigned char>(name[i + 2])) ||
+						! ::isdigit(static_cast<unsigned char>(name[i + 3])))
+					return false;
+
+				if ((name[i + 1] - '0') * 100 + (name[i + 2] - '0') * 10 + (name[i + 3] - '0') > 255)
+					return false;
+
+				i += 4;
+			}
+
+			return true;
+		}
+
+		/* The characters of an escaped label, other than the escaped octets, are valid */
+		static bool check_escaped(const char *p, size_t n) {
+
+			for (size_t i = 0; i < n; ++i) {
+
+				if (p[i] == '\\') {
+					i += ( ::isdigit(static_cast<unsigned char>(p[i + 1])) ? 3 : 1 );
+					continue;
+				}
+
+				if (! domain::is_valid_char(p[i]))
+					return false;
+			}
+
+			return true;
+		}
+
+		/**
+		 * @brief Validates an absolute name with the domain rules
+		 *
+		 * The root name, a leading wildcard label and leading underscore labels
+		 * (service names such as _sip._tcp) are allowed. The rest of an underscore
+		 * label follows the label rules.
+		 *
+		 * A name with \X or \DDD escapes (RFC 1035 section 5.1) is checked label
+		 * by label: an escaped octet may take any value and counts as one toward
+		 * the label and name sizes, the other characters follow the label rules.
+		 */
+		bool validate(const std::string &name, std::string &msg) const {
+
+			if (name.empty())
+				return true;
+
+			bool escaped = ( name.find('\\') != std::string::npos );
+
+			if (! escaped && name.size() > domain::max_name_size) {
+				msg = "Domain name is too big.";
+				return false;
+			}
+
+			size_t start = 0;
+
+			if (name[0] == '*') {
+				if (name.size() == 1)
+					return true;
+				if (name[1] != '.') {
+					msg = "Invalid wildcard label.";
+					return false;
+				}
+				start = 2;
+			}
+
+			size_t size = start;
+			bool leading = true;
+
+			/* Leading underscore labels, and every label of an escaped name */
+			while (start < name.size()) {
+
+				size_t end = start;
+				size_t octets;
+
+				if (! label_end(name, end, octets)) {
+					msg = "Invalid escape sequence in name.";
+					return false;
+				}
+
+				const char *p = name.data() + start;
+				size_t n = end - start;
+
+				leading = leading && n > 0 && p[0] == '_';
+				if (! leading && ! escaped)
+					break;
+
+				size_t skip = ( leading ? 1 : 0 );
+				bool plain = ( std::memchr(p, '\\', n) == nullptr );
+
+				if (octets == 0 || octets > domain::max_label_size ||
+						( plain && ! domain::is_valid_label(p + skip, n - skip) ) ||
+						( ! plain && ! check_escaped(p + skip, n - skip) )) {
+					msg = std::string(leading ? "Invalid underscore label (" : "Invalid label (") +
+						name.substr(start, n) + ").";
+					return false;
+				}
+
+				size += octets + 1;
+				start = end + 1;
+			}
+
+			if (start >= name.size()) {
+				if (size - 1 > domain::max_name_size) {
+					msg = "Domain name is too big.";
+					return false;
+				}
+				return true;
+			}
+
+			domain d(start ? name.substr(start) : name);
+			if (d.has_error()) {
+				msg = d.error();
+				return false;
+			}
+
+			return true;
+		}
+
+		bool check_name(const zone_token &t, const char *what) {
+
+			std::string msg;
+
+			if (! resolve(t, _name, msg) || ! validate(_name, msg)) {
+				error(t.p - _buf, std::string("Invalid ") + what + ". " + msg);
+				return false;
+			}
+
+			return true;
+		}
+
+		void directive(size_t pos) {
+
+			const zone_token &d = _tokens[0];
+
+			if (token_iequals(d, "$ORIGIN")) {
+
+				if (_tokens.size() != 2) {
+					error(pos, "The $ORIGIN directive takes one domain name.");
+					return;
+				}
+
+				if (! check_name(_tokens[1], "$ORIGIN name"))
+					return;
+
+				state.origin = _name;
+				state.has_origin = true;
+				return;
+			}
+
+			if (token_iequals(d, "$TTL")) {
+
+				if (_tokens.size() != 2 || ! parse_ttl(_tokens[1], state.ttl))
+					error(pos, "The $TTL directive takes one TTL value.");
+				return;
+			}
+
+			if (token_iequals(d, "$INCLUDE")) {
+				error(pos, "The $INCLUDE directive is not supported.");
+				return;
+			}
+
+			error(pos, "Unknown directive.");
+		}
+
+		void record(size_t pos, bool has_owner) {
+
+			size_t idx = 0;
+
+			if (has_owner) {
+
+				if (! check_name(_tokens[0], "owner name")) {
+					state.has_owner = false;
+					return;
+				}
+
+				state.owner = _name;
+				state.has_owner = true;
+				idx = 1;
+
+			} else if (! state.has_owner) {
+				error(pos, "Record without an owner name.");
+				return;
+			}
+
+			/* [<TTL>] [<class>] or [<class>] [<TTL>] */
+			for (int i = 0; i < 2 && idx < _tokens.size(); ++i) {
+
+				uint32_t ttl;
+				const zone_token &t = _tokens[idx];
+
+				if (::isdigit(static_cast<unsigned char>(t.p[0]))) {
+					if (! parse_ttl(t, ttl)) {
+						error(t.p - _buf, "Invalid TTL.");
+						return;
+					}
+					++idx;
+				} else if (is_zone_class(t)) {
+					++idx;
+				}
+			}
+
+			if (idx >= _tokens.size()) {
+				error(pos, "Missing record type.");
+				return;
+			}
+
+			const zone_token &type = _tokens[idx++];
+
+			if (! is_zone_type(type)) {
+				error(type.p - _buf, "Unknown record type (" + std::string(type.p, type.n) + ").");
+				return;
+			}
+
+			rdata(type, idx);
+
+			++_records;
+		}
+
+		bool expect(const zone_token &type, size_t idx, size_t count) {
+
+			if (_tokens.size() - idx == count)
+				return true;
+
+			error(type.p - _buf, "Invalid number of RDATA fields for " +
+					std::string(type.p, type.n) + " record.");
+			return false;
+		}
+
+		bool check_number(size_t idx, uint64_t max) {
+
+			uint64_t v;
+			if (parse_number(_tokens[idx], max, v))
+				return true;
+
+			error(_tokens[idx].p - _buf, "Invalid number in RDATA.");
+			return false;
+		}
+
+		void rdata(const zone_token &type, size_t idx) {
+
+			if (token_iequals(type, "A")) {
+
+				if (! expect(type, idx, 1))
+					return;
+
+				net::ipv4 ip(std::string(_tokens[idx].p, _tokens[idx].n));
+				if (ip.has_error())
+					error(_tokens[idx].p - _buf, ip.error());
+
+			} else if (token_iequals(type, "AAAA")) {
+
+				if (! expect(type, idx, 1))
+					return;
+
+				net::ipv6 ip(std::string(_tokens[idx].p, _tokens[idx].n));
+				if (ip.has_error())
+					error(_tokens[idx].p - _buf, ip.error());
+
+			} else if (token_iequals(type, "NS") || token_iequals(type, "CNAME") ||
+					token_iequals(type, "PTR") || token_iequals(type, "DNAME")) {
+
+				if (expect(type, idx, 1))
+					check_name(_tokens[idx], "RDATA name");
+
+			} else if (token_iequals(type, "MX")) {
+
+				/* preference exchange */
+				if (expect(type, idx, 2) && check_number(idx, 0xFFFF))
+					check_name(_tokens[idx + 1], "RDATA name");
+
+			} else if (token_iequals(type, "SRV")) {
+
+				/* priority weight port target */
+				if (expect(type, idx, 4) &&
+						check_number(idx, 0xFFFF) &&
+						check_number(idx + 1, 0xFFFF) &&
+						check_number(idx + 2, 0xFFFF))
+					check_name(_tokens[idx + 3], "RDATA name");
+
+			} else if (token_iequals(type, "SOA")) {
+
+				/* mname rname serial refresh retry expire minimum */
+				if (! expect(type, idx, 7))
+					return;
+
+				if (! check_name(_tokens[idx], "RDATA name") ||
+						! check_name(_tokens[idx + 1], "RDATA name"))
+					return;
+
+				if (! check_number(idx + 2, 0xFFFFFFFF))
+					return;
+
+				for (size_t i = idx + 3; i < idx + 7; ++i) {
+					uint32_t v;
+					if (! parse_ttl(_tokens[i], v)) {
+						error(_tokens[i].p - _buf, "Invalid SOA timer value.");
+						return;
+					}
+				}
+			}
+
+			/* Other types RDATA are not checked */
+		}
+
+		const char *             _buf;
+		size_t                   _size;
+		size_t                   _max_errors;
+		size_t                   _records = 0;
+		size_t                   _error_count = 0;
+
+		std::vector<zone_token>  _tokens;
+		std::vector<zone_error>  _errors;
+		std::string              _name;
+};
+
+} //namespace details
+/// @endcond
+
+/**
+ * @class zone
+ * @brief Validates the syntax of a DNS zone in the master file format
+ *
+ * Owner names and name-typed RDATA (NS, CNAME, PTR, DNAME, MX, SRV and SOA)
+ * are validated with the domain rules, A and AAAA RDATA with the IPv4 and IPv6
+ * rules. Other record types only have their type and syntax checked.
+ *
+ * $INCLUDE is reported as an error: the zone is validated from memory, with no
+ * file system path to resolve the included file against.
+ *
+ * Large inputs are split into chunks parsed by several threads. A chunk starts
+ * at a line beginning with an owner name, speculating it is a record boundary.
+ * The $ORIGIN and $TTL in effect at each chunk start are guessed by a quick scan
+ * for directive lines. Chunks are then checked in order: when the previous chunk
+ * did not stop exactly where the next one started (e.g. the boundary was inside
+ * parentheses), or did not end with the $ORIGIN and $TTL guessed for the next one
+ * (e.g. a '$' line inside parentheses), that chunk is parsed again from the right
+ * place with the right state.
+ *
+ * Does not throw any exception in case of invalid arguments.
+ * Caller must check the zone::has_error().
+ */
+class zone : public error_check {
+
+	public:
+
+		/// The validator type
+		typedef cm::validator<zone, exceptions::invalid_zone> validator_type;
+
+		/// A pointer for a zone object
+		typedef std::shared_ptr<zone> ptr;
+
+		/// An error found in the zone
+		struct error_entry {
+			size_t      line;     ///< line number, starting at 1
+			size_t      offset;   ///< byte offset
+			std::string message;
+		};
+
+		/// The minimum chunk size for parallel parsing
+		static constexpr size_t min_chunk_size = 1 << 20;
+
+		/**
+		 * @brief Validates a zone from memory
+		 *
+		 * @param data       The zone contents
+		 * @param size       The zone contents size
+		 * @param origin     The initial origin. Empty when there is none.
+		 * @param threads    The number of threads. Zero uses the hardware concurrency.
+		 * @param max_errors The maximum number of errors kept.
+		 */
+		zone(const char *data, size_t size, const std::string &origin = "",
+				unsigned threads = 1, size_t max_errors = 100) {
+			parse(data, size, origin, threads, max_errors);
+		}
+
+		/**
+		 * @brief Validates a zone from a string
+		 *
+		 * @param in The zone contents
+		 */
+		zone(const std::string &in) {
+			parse(in.data(), in.size(), "", 1, 100);
+		}
+
+		/**
+		 * @brief Zone object factory method
+		 *
+		 * Memory maps and validates a zone file.
+		 *
+		 * @param path    The zone file path
+		 * @param origin  The initial origin. Empty when there is none.
+		 * @param threads The number of threads. Zero uses the hardware concurrency.
+		 *
+		 * @return The shared pointer
+		 */
+		static ptr open(const std::string &path, const std::string &origin = "", unsigned threads = 0) {
+
+			mapped_file f(path);
+
+			if (f.has_error()) {
+				ptr z(new zone(nullptr, 0));
+				z->set_error(f);
+				return z;
+			}
+
+			return ptr(new zone(f.data(), f.size(), origin, threads));
+		}
+
+		/// The number of records found
+		inline size_t records() const { return _records; }
+
+		/// The number of errors found. It may be larger than errors().size()
+		inline size_t error_count() const { return _error_count; }
+
+		/// The first errors found, ordered by position
+		inline const std::vector<error_entry> & errors() const { return _errors; }
+
+	private:
+
+		void parse(const char *data, size_t size, const std::string &origin,
+				unsigned threads, size_t max_errors) {
+
+			details::zone_state initial;
+
+			if (! origin.empty()) {
+				initial.origin = origin;
+				if (initial.origin.back() == '.')
+					initial.origin.pop_back();
+				initial.has_origin = true;
+			}
+
+			if (threads == 0)
+				threads = std::max(1u, std::thread::hardware_concurrency());
+
+			size_t chunks = std::min<size_t>(threads, std::max<size_t>(1, size / min_chunk_size));
+
+			/* Chunk boundaries at lines starting with an owner name */
+			std::vector<size_t> bounds(1, 0);
+
+			for (size_t k = 1; k < chunks; ++k) {
+				size_t b = boundary(data, size, (size / chunks) * k);
+				if (b > bounds.back() && b < size)
+					bounds.push_back(b);
+			}
+
+			bounds.push_back(size);
+			chunks = bounds.size() - 1;
+
+			/* Origin and TTL in effect at each boundary */
+			std::vector<details::zone_reader> readers;
+			readers.reserve(chunks);
+
+			for (size_t k = 0; k < chunks; ++k) {
+				readers.emplace_back(data, size, max_errors);
+				readers.back().state = initial;
+			}
+
+			if (chunks > 1)
+				directives(data, size, bounds, readers);
+
+			std::vector<details::zone_state> starts;
+			for (auto &r : readers)
+				starts.push_back(r.state);
+
+			std::vector<size_t> stops(chunks, 0);
+
+			if (chunks == 1) {
+				stops[0] = readers[0].parse(0, size);
+			} else {
+				std::vector<std::thread> workers;
+
+				for (size_t k = 0; k < chunks; ++k)
+					workers.emplace_back([&, k]() {
+							stops[k] = readers[k].parse(bounds[k], bounds[k + 1]);
+							});
+
+				for (auto &w : workers)
+					w.join();
+			}
+
+			/* Checks speculative boundaries and parses again where wrong */
+			for (size_t k = 1; k < chunks; ++k) {
+
+				if (stops[k - 1] == bounds[k] &&
+						details::same_directives(readers[k - 1].state, starts[k]))
+					continue;
+
+				details::zone_reader r(data, size, max_errors);
+				r.state = readers[k - 1].state;
+				stops[k] = r.parse(stops[k - 1], bounds[k + 1]);
+				readers[k] = std::move(r);
+			}
+
+			std::vector<details::zone_error> errors;
+
+			for (auto &r : readers) {
+				_records += r.records();
+				_error_count += r.error_count();
+
+				for (auto &e : r.errors())
+					if (errors.size() < max_errors)
+						errors.emplace_back(std::move(e));
+			}
+
+			/* Line numbers only for the reported errors */
+			size_t line = 1;
+			size_t pos = 0;
+
+			for (auto &e : errors) {
+
+				while (pos < e.offset) {
+					const char *nl = static_cast<const char *>(std::memchr(data + pos, '\n', e.offset - pos));
+					if (! nl)
+						break;
+					++line;
+					pos = (nl - data) + 1;
+				}
+
+				_errors.push_back(error_entry{ line, e.offset, std::move(e.message) });
+			}
+
+			if (! _errors.empty())
+				set_error("Line " + std::to_string(_errors.front().line) + ": " + _errors.front().message);
+		}
+
+		/* Next line at or after pos starting with an owner name */
+		static size_t boundary(const char *data, size_t size, size_t pos) {
+
+			while (pos < size) {
+
+				const char *nl = static_cast<const char *>(std::memchr(data + pos, '\n', size - pos));
+				if (! nl)
+					return size;
+
+				pos = (nl - data) + 1;
+
+				if (pos < size) {
+					char c = data[pos];
+					if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != ';' && c != '$' && c != '(')
+						return pos;
+				}
+			}
+
+			return size;
+		}
+
+		/* Applies the $ORIGIN and $TTL lines found before each chunk start: a guess, as
+		 * a '$' line may also be inside parentheses, which parse() checks */
+		static void directives(const char *data, size_t size, const std::vector<size_t> &bounds,
+				std::vector<details::zone_reader> &readers) {
+
+			details::zone_reader scan(data, size, 0);
+			scan.state = readers[0].state;
+
+			size_t k = 1;
+
+			for (size_t pos = 0; pos < size; ) {
+
+				const char *d = static_cast<const char *>(std::memchr(data + pos, '$', size - pos));
+				size_t at = ( d ? static_cast<size_t>(d - data) : size );
+
+				while (k < readers.size() && bounds[k] <= at)
+					readers[k++].state = scan.state;
+
+				if (! d)
+					break;
+
+				if (at == 0 || data[at - 1] == '\n')
+					scan.apply_directive(at);
+
+				pos = at + 1;
+			}
+
+			/* Owner names never carry over speculative boundaries */
+			for (k = 1; k < readers.size(); ++k)
+				readers[k].state.has_owner = false;
+		}
+
+		std::vector<error_entry>  _errors;
+		size_t                    _records = 0;
+		size_t                    _error_count = 0;
+
+};
+
+}//namespace dns
+}//namespace cm
+
+#endif //_CM_ZONE_